@@ -0,0 +1,351 @@
+/**
+ * @file dispatch.cpp
+ * @brief End-to-end dispatch latency benchmark (`dev_bench_dispatch`).
+ *
+ * Measures `dev <plugin>` against exec'ing the same no-op plugin directly,
+ * across synthetic plugin trees, and compares the overhead (p50 of dev
+ * minus p50 of the direct run) with a stored baseline.
+ *
+ * Usage:
+ *   dev_bench_dispatch --dev <Dev> --plugin <noop> [--baseline <file>]
+ *                      [--runs N] [--tolerance 0.25] [--slack-us 200]
+ *                      [--update-baseline]
+ *
+ * Exit code: 0 ok, 1 overhead regressed past the baseline, 2 usage/setup error.
+ */
+
+#include "dev/process.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <print>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// ── Options ─────────────────────────────────────────────────
+
+struct Options
+{
+    fs::path dev;
+    fs::path plugin;
+    fs::path baseline;
+    int runs = 200;
+    double tolerance = 0.25; ///< allowed relative regression
+    double slack_us = 200;   ///< absolute allowance on top (timer noise)
+    bool update = false;
+};
+
+// ── Scenarios ───────────────────────────────────────────────
+
+struct Scenario
+{
+    std::string name;
+    int plugins_per_dir = 1;
+    int dirs = 1;
+    int aliases = 0;
+    bool missing = false;
+};
+
+/// Name a plugin file the way resolve_plugin() expects it.
+static std::string plugin_file(std::string_view name)
+{
+#ifdef _WIN32
+    return std::string(name) + ".exe";
+#else
+    return std::string(name);
+#endif
+}
+
+/// Hard-link (or copy) the no-op plugin: 1000 copies of a real binary
+/// would dwarf the thing being measured.
+static bool place_plugin(const fs::path& src, const fs::path& dst)
+{
+    std::error_code ec;
+    fs::create_hard_link(src, dst, ec);
+    if (ec) {
+        fs::copy_file(src, dst, fs::copy_options::overwrite_existing, ec);
+    }
+    return !ec;
+}
+
+/// Build the scenario tree under `root`; the target plugin ("target") lives
+/// in the last dir searched, so every dir is probed.
+static bool setup(const Scenario& sc, const fs::path& root, const fs::path& noop)
+{
+    std::error_code ec;
+    fs::remove_all(root, ec);
+
+    std::vector<fs::path> dirs;
+    for (int d = 0; d < sc.dirs; ++d) {
+        // dirs[0] is the cwd-relative plugins/, the rest come from dev.toml.
+        auto dir = (d == 0) ? root / "plugins" : root / ("extra" + std::to_string(d));
+        fs::create_directories(dir, ec);
+        for (int p = 0; p < sc.plugins_per_dir - 1; ++p) {
+            auto name = "p" + std::to_string(d) + "_" + std::to_string(p);
+            if (!place_plugin(noop, dir / plugin_file(name))) {
+                return false;
+            }
+        }
+        dirs.push_back(dir);
+    }
+    if (!place_plugin(noop, dirs.back() / plugin_file("target"))) {
+        return false;
+    }
+
+    std::ofstream toml(root / "dev.toml");
+    if (sc.dirs > 1) {
+        toml << "[plugins]\ndirs = [";
+        for (std::size_t i = 1; i < dirs.size(); ++i) {
+            toml << (i > 1 ? ", " : "") << '"' << dirs[i].generic_string() << '"';
+        }
+        toml << "]\n";
+    }
+    if (sc.aliases > 0) {
+        toml << "[alias]\n";
+        for (int i = 0; i < sc.aliases; ++i) {
+            toml << "a" << i << " = p0_" << i << "\n";
+        }
+    }
+    return static_cast<bool>(toml);
+}
+
+// ── Measurement ─────────────────────────────────────────────
+
+struct Stats
+{
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+/// Nearest-rank percentiles over the samples (microseconds).
+static Stats summarize(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        auto i = static_cast<std::size_t>(q * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[i];
+    };
+    return {at(0.50), at(0.90), at(0.99), samples.back()};
+}
+
+/// Run `argv` `runs` times in `cwd` with output discarded.
+static std::vector<double>
+measure(const std::vector<std::string>& args, const fs::path& cwd, char* const* envp, int runs)
+{
+    std::vector<const char*> argv;
+    for (const auto& a : args) {
+        argv.push_back(a.c_str());
+    }
+    argv.push_back(nullptr);
+
+#ifdef _WIN32
+    int null_fd = _open("NUL", _O_WRONLY);
+#else
+    int null_fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+#endif
+    auto cwd_str = cwd.string();
+    dev::SpawnOptions opts;
+    opts.out = null_fd;
+    opts.err = null_fd;
+    opts.cwd = cwd_str.c_str();
+    opts.envp = envp;
+
+    // A few untimed runs first: page cache, plugin index, dynamic loader.
+    constexpr int warmup = 10;
+    std::vector<double> samples;
+    samples.reserve(static_cast<std::size_t>(runs));
+    for (int i = -warmup; i < runs; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        auto pid = dev::start(argv[0], argv.data(), opts);
+        if (pid != -1) {
+            dev::wait_for(pid);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        if (i >= 0) {
+            samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        }
+    }
+
+#ifdef _WIN32
+    _close(null_fd);
+#else
+    ::close(null_fd);
+#endif
+    return samples;
+}
+
+// ── Baseline ────────────────────────────────────────────────
+
+/// Baseline file: one "<scenario> <p50 overhead µs>" per line, '#' comments.
+static std::map<std::string, double> load_baseline(const fs::path& path)
+{
+    std::map<std::string, double> out;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double value = 0;
+        if (fields >> name >> value) {
+            out[name] = value;
+        }
+    }
+    return out;
+}
+
+static void save_baseline(const fs::path& path, const std::map<std::string, double>& values)
+{
+    std::ofstream out(path);
+    out << "# dev_bench_dispatch baseline: p50 dispatch overhead in µs over a direct exec.\n"
+        << "# Regenerate with: dev_bench_dispatch ... --update-baseline\n";
+    for (const auto& [name, value] : values) {
+        out << name << ' ' << static_cast<long long>(value + 0.5) << '\n';
+    }
+}
+
+// ── Main ────────────────────────────────────────────────────
+
+static bool parse_args(int argc, char* argv[], Options& o)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+        if (a == "--dev" && (v = next())) {
+            o.dev = fs::absolute(v);
+        } else if (a == "--plugin" && (v = next())) {
+            o.plugin = fs::absolute(v);
+        } else if (a == "--baseline" && (v = next())) {
+            o.baseline = fs::absolute(v);
+        } else if (a == "--runs" && (v = next())) {
+            o.runs = std::max(1, std::atoi(v));
+        } else if (a == "--tolerance" && (v = next())) {
+            o.tolerance = std::atof(v);
+        } else if (a == "--slack-us" && (v = next())) {
+            o.slack_us = std::atof(v);
+        } else if (a == "--update-baseline") {
+            o.update = true;
+        } else {
+            return false;
+        }
+    }
+    return !o.dev.empty() && !o.plugin.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::println(stderr,
+                     "usage: dev_bench_dispatch --dev <Dev> --plugin <noop> [--baseline <file>]\n"
+                     "                          [--runs N] [--tolerance F] [--slack-us US]\n"
+                     "                          [--update-baseline]");
+        return 2;
+    }
+
+    const std::vector<Scenario> scenarios = {
+        {"plugins-1", 1, 1, 0, false},
+        {"plugins-10", 10, 1, 0, false},
+        {"plugins-1000", 1000, 1, 0, false},
+        {"dirs-5", 1, 5, 0, false},
+        {"dirs-20", 1, 20, 0, false},
+        {"aliases-5000", 1, 1, 5000, false},
+        {"missing", 10, 1, 0, true},
+    };
+
+    std::error_code ec;
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto root = fs::temp_directory_path(ec) / ("dev-bench-" + std::to_string(stamp));
+
+    // Isolated environment: no user config, no daemon, private cache.
+    auto home = root / "home";
+    fs::create_directories(home, ec);
+    std::vector<std::string> env_strings = {
+        "HOME=" + home.string(),
+        "DEV_NO_DAEMON=1",
+        "DEV_CACHE_DIR=" + (root / "cache").string(),
+    };
+    if (const char* path = std::getenv("PATH")) {
+        env_strings.push_back(std::string("PATH=") + path);
+    }
+#ifdef _WIN32
+    env_strings.push_back("APPDATA=" + home.string());
+    if (const char* sysroot = std::getenv("SystemRoot")) {
+        env_strings.push_back(std::string("SystemRoot=") + sysroot);
+    }
+#endif
+    std::vector<char*> envp;
+    for (auto& s : env_strings) {
+        envp.push_back(s.data());
+    }
+    envp.push_back(nullptr);
+
+    auto dev_str = opt.dev.string();
+    auto direct = summarize(measure({opt.plugin.string()}, home, envp.data(), opt.runs));
+
+    std::println("{:<14} {:>9} {:>9} {:>9} {:>9} {:>10} {:>9}",
+                 "scenario", "p50 µs", "p90 µs", "p99 µs", "max µs", "overhead", "baseline");
+    std::println("{:<14} {:>9.0f} {:>9.0f} {:>9.0f} {:>9.0f} {:>10} {:>9}",
+                 "direct", direct.p50, direct.p90, direct.p99, direct.max, "-", "-");
+
+    auto baseline = opt.baseline.empty() ? std::map<std::string, double>{}
+                                         : load_baseline(opt.baseline);
+    std::map<std::string, double> measured;
+    int status = 0;
+
+    for (const auto& sc : scenarios) {
+        auto dir = root / sc.name;
+        if (!setup(sc, dir, opt.plugin)) {
+            std::println(stderr, "bench: cannot set up scenario '{}' in {}", sc.name, dir.string());
+            fs::remove_all(root, ec);
+            return 2;
+        }
+
+        std::string command = sc.missing ? "no-such-command" : "target";
+        auto s = summarize(measure({dev_str, command}, dir, envp.data(), opt.runs));
+        double overhead = s.p50 - direct.p50;
+        measured[sc.name] = std::max(0.0, overhead);
+
+        std::string base = "-";
+        std::string mark;
+        if (auto it = baseline.find(sc.name); it != baseline.end()) {
+            base = std::to_string(static_cast<long long>(it->second));
+            if (!opt.update && overhead > it->second * (1 + opt.tolerance) + opt.slack_us) {
+                mark = "  ✗ regressed";
+                status = 1;
+            }
+        }
+        std::println("{:<14} {:>9.0f} {:>9.0f} {:>9.0f} {:>9.0f} {:>10.0f} {:>9}{}",
+                     sc.name, s.p50, s.p90, s.p99, s.max, overhead, base, mark);
+    }
+
+    fs::remove_all(root, ec);
+
+    if (!opt.baseline.empty() && (opt.update || !fs::exists(opt.baseline))) {
+        save_baseline(opt.baseline, measured);
+        std::println("baseline written to {}", opt.baseline.string());
+    }
+    return status;
+}
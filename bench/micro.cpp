@@ -0,0 +1,326 @@
+/**
+ * @file micro.cpp
+ * @brief Microbenchmarks for the header-only building blocks (`dev_bench_micro`).
+ *
+ * Times Config, plugin resolution/listing, plugin metadata, suggestions and style helpers
+ * in isolation and counts heap allocations per call through a replaced
+ * global operator new.  Allocation counts are deterministic, so each benchmark
+ * carries an allocation budget; exceeding it fails the run even when the
+ * timings are too noisy to judge.
+ *
+ * Usage:  dev_bench_micro [--min-time-ms N] [filter]
+ *
+ * Exit code: 0 ok, 1 an allocation budget was exceeded.
+ */
+
+#include "dev/config.hpp"
+#include "dev/dispatcher.hpp"
+#include "dev/plugin_meta.hpp"
+#include "dev/style.hpp"
+#include "dev/suggest.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Gives plugin_meta/read a real note to find in this binary.
+DEV_PLUGIN_META("micro", "Microbenchmarks for dev's building blocks", "1.0.0", "", "--min-time-ms")
+
+// ── Allocation counting ─────────────────────────────────────
+
+// Atomic: list_plugins() scans dirs on helper threads.
+static std::atomic<std::size_t> g_allocs = 0;
+static std::atomic<std::size_t> g_alloc_bytes = 0;
+
+void* operator new(std::size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+// GCC cannot see that these pair with the operator new above.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// ── Harness ─────────────────────────────────────────────────
+
+/// Results are folded into this so the optimizer cannot drop the work.
+static volatile std::size_t g_sink = 0;
+
+static std::chrono::milliseconds g_min_time{200};
+static std::string_view g_filter;
+static int g_failures = 0;
+
+/// Run `fn` (returning something size-like) until `g_min_time` has passed,
+/// then report median ns/op over batches and allocations per call.
+///
+/// @param budget  Max allocations per call (measured with libstdc++; lower
+///                it when a change removes allocations).  Negative = unchecked.
+template <typename F>
+static void bench(std::string_view name, double budget, F&& fn)
+{
+    if (!g_filter.empty() && name.find(g_filter) == std::string_view::npos) {
+        return;
+    }
+    using clock = std::chrono::steady_clock;
+
+    // Calibrate a batch to ~1/20 of the time budget.
+    std::size_t batch = 1;
+    for (;;) {
+        auto t0 = clock::now();
+        for (std::size_t i = 0; i < batch; ++i) {
+            g_sink = g_sink + fn();
+        }
+        if (clock::now() - t0 >= g_min_time / 20 || batch >= (std::size_t{1} << 30)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    std::vector<double> per_op;
+    std::size_t calls = 0;
+    std::size_t allocs = 0;
+    std::size_t bytes = 0;
+    auto deadline = clock::now() + g_min_time;
+    while (per_op.size() < 5 || clock::now() < deadline) {
+        std::size_t a0 = g_allocs;
+        std::size_t b0 = g_alloc_bytes;
+        auto t0 = clock::now();
+        for (std::size_t i = 0; i < batch; ++i) {
+            g_sink = g_sink + fn();
+        }
+        auto t1 = clock::now();
+        allocs += g_allocs - a0;
+        bytes += g_alloc_bytes - b0;
+        calls += batch;
+        per_op.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                         static_cast<double>(batch));
+    }
+    std::sort(per_op.begin(), per_op.end());
+
+    auto n = static_cast<double>(calls);
+    double allocs_per_op = static_cast<double>(allocs) / n;
+    std::string mark;
+    if (budget >= 0 && allocs_per_op > budget + 1e-9) {
+        mark = std::format("  ✗ over alloc budget ({})", budget);
+        ++g_failures;
+    }
+    std::println("{:<34} {:>12.1f} {:>10.2f} {:>12.1f}{}",
+                 name,
+                 per_op[per_op.size() / 2],
+                 allocs_per_op,
+                 static_cast<double>(bytes) / n,
+                 mark);
+}
+
+// ── Fixtures ────────────────────────────────────────────────
+
+struct Fixture
+{
+    fs::path root;
+    fs::path small_toml;
+    fs::path large_toml;
+    std::vector<fs::path> dirs;
+
+    Fixture()
+    {
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::error_code ec;
+        root = fs::temp_directory_path(ec) / ("dev-micro-" + std::to_string(stamp));
+        fs::create_directories(root, ec);
+
+        // Compiled config images go to the fixture, not the user's cache.
+        auto cache = (root / "cache").string();
+#ifdef _WIN32
+        _putenv_s("DEV_CACHE_DIR", cache.c_str());
+#else
+        setenv("DEV_CACHE_DIR", cache.c_str(), 1);
+#endif
+
+        small_toml = root / "small.toml";
+        std::ofstream(small_toml) << "# project config\n"
+                                     "[alias]\n"
+                                     "b = build\n"
+                                     "r = run\n"
+                                     "c = create\n"
+                                     "[plugins]\n"
+                                     "dirs = [\"~/.dev/plugins\", \"/opt/dev/plugins\"]\n"
+                                     "[dispatch]\n"
+                                     "exec = true\n";
+
+        // ~20k lines: 5000 aliases + 200 sections of 75 keys + lists.
+        large_toml = root / "large.toml";
+        std::ofstream large(large_toml);
+        large << "[alias]\n";
+        for (int i = 0; i < 5000; ++i) {
+            large << "a" << i << " = \"command-" << i << "\"\n";
+        }
+        for (int s = 0; s < 200; ++s) {
+            large << "[section" << s << "]\n";
+            for (int k = 0; k < 75; ++k) {
+                large << "key" << k << " = value-" << s << "-" << k << "\n";
+            }
+            large << "list = [\"a\", \"b\", \"c\", \"d\"]\n";
+        }
+
+        // 20 dirs x 50 plugins, half the names shared with the next dir.
+        for (int d = 0; d < 20; ++d) {
+            auto dir = root / ("plugins" + std::to_string(d));
+            fs::create_directories(dir, ec);
+            for (int p = 0; p < 50; ++p) {
+                std::ofstream(dir / ("tool" + std::to_string(d * 25 + p)));
+            }
+            dirs.push_back(dir);
+        }
+    }
+
+    ~Fixture()
+    {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    Fixture(const Fixture&) = delete;
+    Fixture& operator=(const Fixture&) = delete;
+};
+
+// ── Main ────────────────────────────────────────────────────
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--min-time-ms" && i + 1 < argc) {
+            g_min_time = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        } else if (a == "--help" || a == "-h") {
+            std::println("usage: dev_bench_micro [--min-time-ms N] [filter]");
+            return 0;
+        } else {
+            g_filter = a;
+        }
+    }
+
+    Fixture fx;
+    const auto small = dev::Config::load(fx.small_toml);
+    const auto large = dev::Config::load(fx.large_toml, false);
+    const auto compiled = dev::Config::load(fx.large_toml); // writes the image
+    const std::string last_plugin = "tool" + std::to_string(19 * 25 + 49);
+
+    std::println("{:<34} {:>12} {:>10} {:>12}", "benchmark", "ns/op", "allocs/op", "bytes/op");
+
+    // Config
+    bench("config/load/small", 15, [&] {
+        return dev::Config::load(fx.small_toml).path().native().size();
+    });
+    bench("config/load/large", 49, [&] {
+        return dev::Config::load(fx.large_toml, false).path().native().size();
+    });
+    bench("config/load/large/compiled", 22, [&] {
+        return dev::Config::load(fx.large_toml).path().native().size();
+    });
+    bench("config/get/hit", 0, [&] { return large.get("section150", "key42").size(); });
+    bench("config/get/miss", 0, [&] { return large.get("alias", "no-such-alias").size(); });
+    bench("config/get_list", 2, [&] { return small.get_list("plugins", "dirs").size(); });
+    bench("config/get_section/small", 4, [&] { return small.get_section("alias").size(); });
+    bench("config/get_section/5000", 5009, [&] { return large.get_section("alias").size(); });
+    bench("config/value/hit", 0, [&] { return large.value("section150", "key42")->size(); });
+    bench("config/section/5000", 0, [&] { return large.section("alias").size(); });
+    bench("config/value/compiled", 0, [&] {
+        return compiled.value("section150", "key42")->size();
+    });
+
+    // Dispatcher
+    bench("resolve_plugin/first-dir", 5, [&] {
+        return dev::resolve_plugin("tool0", fx.dirs).native().size();
+    });
+    bench("resolve_plugin/last-of-20", 100, [&] {
+        return dev::resolve_plugin(last_plugin, fx.dirs).native().size();
+    });
+    bench("resolve_plugin/miss-20", 100, [&] {
+        return dev::resolve_plugin("missing", fx.dirs).native().size();
+    });
+    bench("list_plugins/20-dirs-dedupe", 271, [&] { return dev::list_plugins(fx.dirs).size(); });
+
+    // Plugin metadata
+    const fs::path self = argv[0];
+    bench("plugin_meta/read", 1, [&] {
+        return dev::read_plugin_meta(self).value_or(dev::PluginMeta{}).description.size();
+    });
+    bench("plugin_meta/not-elf", 1, [&] {
+        return dev::read_plugin_meta(fx.small_toml).has_value() ? 1u : 0u;
+    });
+
+    // Suggestions
+    const auto names = dev::list_plugins(fx.dirs);
+    bench("suggest/525-names", 7, [&] { return dev::suggest("tol42", names).size(); });
+    bench("suggest/525-names/miss", 0, [&] { return dev::suggest("xyzzy", names).size(); });
+
+    // Style
+    dev::style::g_colors = false;
+    bench("style/styled/plain", 0, [] { return dev::style::cyan_text("build").size(); });
+    dev::style::g_colors = true;
+    bench("style/styled/color", 0, [] { return dev::style::cyan_text("build").size(); });
+    bench("style/styled/color-long", 3, [] {
+        return dev::style::dim_text("a description long enough to defeat SSO").size();
+    });
+    std::string line;
+    line.reserve(256);
+    bench("style/paint/color-long", 0, [&] {
+        line.clear();
+        std::format_to(std::back_inserter(line),
+                       "  {:<22} {}",
+                       dev::style::paint(dev::style::cyan, "build"),
+                       dev::style::paint(dev::style::dim, "a description long enough to defeat SSO"));
+        return line.size();
+    });
+
+    if (g_failures > 0) {
+        std::println(stderr, "{} benchmark(s) over their allocation budget", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,9 @@
+/**
+ * @file noop.cpp
+ * @brief Benchmark plugin that does nothing — isolates dispatcher cost.
+ */
+
+int main()
+{
+    return 0;
+}
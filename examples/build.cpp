@@ -2,15 +2,33 @@
  * @file build.cpp
  * @brief Plugin — auto-detect build system and build the project.
  *
- * Usage:  dev build [--release]
+ * Usage:  dev build [--release] [--force] [-D<var>=<value>...]
+ *
+ * Steps whose inputs did not change since their last successful run are
+ * skipped: the CMake configure step and the npm build (hashes in
+ * .dev/build.state, the format of `dev task`).  Make projects ask
+ * `make -q`; Cargo and Go are incremental on their own and always run.
+ * --force runs everything.
  */
 
+#include "dev/cache.hpp"
+#include "dev/config.hpp"
+#include "dev/mmap.hpp"
+#include "dev/plugin.hpp"
+#include "dev/tasks.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <initializer_list>
 #include <print>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -57,60 +75,378 @@ static const char* name_of(BuildSystem bs)
     }
 }
 
-static int build_cmake(bool release)
+/// Run a build step; under `dev --trace=<file>` it becomes a span in the
+/// dispatcher's trace (see build_main()).
+static int run(const std::string& cmd)
 {
-    auto type = release ? "Release" : "Debug";
-    std::string configure = std::string("cmake -B build -DCMAKE_BUILD_TYPE=") + type;
-    std::string build = std::string("cmake --build build --config ") + type;
+    std::println("→ {}", cmd);
+    dev::trace::Span span(cmd);
+    return std::system(cmd.c_str());
+}
+
+// ── Fingerprints ────────────────────────────────────────────
+
+/// Hash `bytes` plus a terminator, so adjacent fields cannot run together.
+static std::uint64_t hash_field(std::uint64_t h, std::string_view bytes)
+{
+    h = dev::fnv1a64(bytes, h);
+    return dev::fnv1a64(std::string_view("\0", 1), h);
+}
+
+/// Path and contents of a file; a missing file hashes differently from an
+/// empty one.
+static std::uint64_t hash_file(std::uint64_t h, const fs::path& path)
+{
+    auto file = dev::MappedFile::open(path);
+    h = hash_field(h, path.generic_string());
+    h = hash_field(h, file.is_open() ? "+" : "-");
+    return hash_field(h, file.view());
+}
+
+/// Identity (inode, size, mtime) of a tool binary: an upgraded compiler
+/// changes it without changing any project file.
+static std::uint64_t hash_tool(std::uint64_t h, const fs::path& path)
+{
+    auto stamp = dev::stamp_of(path);
+    h = hash_field(h, path.generic_string());
+    return hash_field(h, std::string_view(reinterpret_cast<const char*>(&stamp), sizeof stamp));
+}
+
+static std::uint64_t hash_env(std::uint64_t h, std::initializer_list<const char*> names)
+{
+    for (const char* name : names) {
+        const char* value = std::getenv(name);
+        h = hash_field(h, name);
+        h = hash_field(h, value ? value : "\x01unset");
+    }
+    return h;
+}
+
+/// `name` looked up in PATH, or empty.
+static fs::path find_program(std::string_view name)
+{
+#ifdef _WIN32
+    constexpr char sep = ';';
+    std::string file = std::string(name) + ".exe";
+#else
+    constexpr char sep = ':';
+    std::string file(name);
+#endif
+    const char* path = std::getenv("PATH");
+    std::string_view dirs = path ? path : "";
+    std::error_code ec;
+    while (!dirs.empty()) {
+        auto end = dirs.find(sep);
+        auto dir = dirs.substr(0, end);
+        dirs.remove_prefix(end == std::string_view::npos ? dirs.size() : end + 1);
+        if (dir.empty()) {
+            continue;
+        }
+        fs::path candidate = fs::path(dir) / file;
+        if (fs::is_regular_file(candidate, ec)) {
+            return candidate;
+        }
+    }
+    return {};
+}
+
+static std::uint64_t hash_programs(std::uint64_t h, std::initializer_list<std::string_view> names)
+{
+    for (auto name : names) {
+        h = hash_tool(h, find_program(name));
+    }
+    return h;
+}
+
+/// Hash the project files (relative to the cwd, in sorted order) for which
+/// `want(path)` holds.  Hidden directories and those `skip(dir)` rejects
+/// are not entered.
+template <typename Want, typename Skip>
+static std::uint64_t hash_tree(std::uint64_t h, Want want, Skip skip)
+{
+    std::vector<std::string> files;
+    std::error_code ec;
+    auto opts = fs::directory_options::skip_permission_denied;
+    fs::recursive_directory_iterator it(".", opts, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const auto& entry = *it;
+        if (entry.is_directory(ec)) {
+            if (entry.path().filename().string().starts_with('.') || skip(entry.path())) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (entry.is_regular_file(ec) && want(entry.path())) {
+            files.push_back(entry.path().lexically_relative(".").generic_string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto& f : files) {
+        h = hash_file(h, f);
+    }
+    return h;
+}
+
+/// Which of the output `dirs` exist: one deleted since (dev clean) means
+/// the build must run again.
+static std::uint64_t hash_outputs(std::initializer_list<fs::path> dirs)
+{
+    std::uint64_t h = dev::fnv1a64("outputs");
+    std::error_code ec;
+    for (const auto& dir : dirs) {
+        h = hash_field(h, fs::is_directory(dir, ec) ? "1" : "0");
+    }
+    return h;
+}
+
+// ── Build systems ───────────────────────────────────────────
+
+/// Value of `key` in CMakeCache.txt (`KEY:TYPE=VALUE` lines), or empty.
+static std::string_view cmake_cache_value(std::string_view cache, std::string_view key)
+{
+    while (!cache.empty()) {
+        auto nl = cache.find('\n');
+        auto line = cache.substr(0, nl);
+        cache.remove_prefix(nl == std::string_view::npos ? cache.size() : nl + 1);
+        if (line.size() > key.size() && line.starts_with(key) &&
+            (line[key.size()] == ':' || line[key.size()] == '=')) {
+            auto value = line.substr(line.find('=') + 1);
+            if (value.ends_with('\r')) {
+                value.remove_suffix(1);
+            }
+            return value;
+        }
+    }
+    return {};
+}
+
+/// Everything `cmake -B build` depends on: the command, every
+/// CMakeLists.txt / *.cmake / preset file, the toolchain file, the
+/// environment CMake reads, the cache's current values of the variables
+/// we pass, and the identity of the compilers and of cmake itself as
+/// recorded in the cache.
+static std::uint64_t cmake_fingerprint(const std::string& configure,
+                                       const std::vector<std::string>& defines)
+{
+    std::uint64_t h = hash_field(dev::fnv1a64("cmake"), configure);
+    h = hash_tree(
+        h,
+        [](const fs::path& p) {
+            auto name = p.filename();
+            return name == "CMakeLists.txt" || p.extension() == ".cmake" ||
+                   name == "CMakePresets.json" || name == "CMakeUserPresets.json";
+        },
+        [](const fs::path& dir) {
+            std::error_code ec;
+            return dir.filename() == "node_modules" || fs::exists(dir / "CMakeCache.txt", ec);
+        });
+    h = hash_env(h,
+                 {"CC",
+                  "CXX",
+                  "CFLAGS",
+                  "CXXFLAGS",
+                  "LDFLAGS",
+                  "CMAKE_GENERATOR",
+                  "CMAKE_TOOLCHAIN_FILE",
+                  "CMAKE_PREFIX_PATH"});
+
+    // A `cmake -D...` run by hand since, e.g. another build type, means
+    // our defines no longer hold.
+    auto cache_file = dev::MappedFile::open(fs::path("build") / "CMakeCache.txt");
+    auto cache = cache_file.view();
+    for (std::string_view d : defines) {
+        auto key = d.substr(2, d.find_first_of(":=") - 2);
+        h = hash_field(h, cmake_cache_value(cache, key));
+    }
+    for (auto key : {"CMAKE_C_COMPILER", "CMAKE_CXX_COMPILER", "CMAKE_COMMAND"}) {
+        if (auto tool = cmake_cache_value(cache, key); !tool.empty()) {
+            h = hash_tool(h, fs::path(tool));
+        }
+    }
+
+    std::string_view toolchain = cmake_cache_value(cache, "CMAKE_TOOLCHAIN_FILE");
+    if (const char* env = std::getenv("CMAKE_TOOLCHAIN_FILE"); toolchain.empty() && env) {
+        toolchain = env;
+    }
+    if (!toolchain.empty()) {
+        // Relative toolchain paths are tried against the build dir first.
+        fs::path file(toolchain);
+        std::error_code ec;
+        if (file.is_relative() && fs::exists(fs::path("build") / file, ec)) {
+            file = fs::path("build") / file;
+        }
+        h = hash_file(h, file);
+    }
+    return h;
+}
+
+/// Files `npm run build` reads: `[build] inputs` in dev.toml (globs or
+/// directories, as for `dev task`), else the top-level files (package.json,
+/// lockfiles, compiler and bundler configs) plus the conventional source
+/// dirs.  Tests, fixtures and data stay out: hashing them would cost more
+/// than the build's own no-op check.
+static std::vector<std::string> npm_inputs()
+{
+    auto patterns = dev::Config::load("dev.toml").get_list("build", "inputs");
+    if (!patterns.empty()) {
+        return dev::expand_globs(patterns, ".");
+    }
+    std::vector<std::string> files = dev::expand_globs(
+        {"src", "public", "app", "pages", "components", "styles", "assets", "static"}, ".");
+    std::error_code ec;
+    fs::directory_iterator it(".", ec);
+    for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            files.push_back(it->path().filename().generic_string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static std::uint64_t npm_fingerprint(const std::string& cmd)
+{
+    std::uint64_t h = hash_field(dev::fnv1a64("npm"), cmd);
+    for (const auto& f : npm_inputs()) {
+        h = hash_file(h, f);
+    }
+    // Rewritten by every `npm install`.
+    h = hash_file(h, fs::path("node_modules") / ".package-lock.json");
+    h = hash_env(h, {"NODE_ENV"});
+    return hash_programs(h, {"node", "npm"});
+}
+
+static std::uint64_t npm_outputs()
+{
+    return hash_outputs({"dist", "build", "out", ".next"});
+}
 
-    std::println("→ {}", configure);
-    if (int rc = std::system(configure.c_str()); rc != 0)
-        return rc;
+/// Run `cmd` unless step `key`'s inputs still hash to `fp` and `outputs()`
+/// still hashes as it did, both recorded after its last successful run.
+/// Inputs are hashed before the run, so an edit made during a build is
+/// not taken as built.
+template <typename Outputs>
+static int run_step(const std::string& cmd,
+                    const std::string& key,
+                    std::uint64_t fp,
+                    Outputs outputs,
+                    bool force,
+                    dev::TaskState& state)
+{
+    if (!force && state.matches(key, fp) && state.matches(key + "-outputs", outputs())) {
+        std::println("build: nothing changed since the last build, skipping `{}`", cmd);
+        return 0;
+    }
+    int rc = run(cmd);
+    if (rc == 0) {
+        state.record(key, fp);
+        state.record(key + "-outputs", outputs());
+    } else {
+        state.forget(key);
+    }
+    state.save();
+    return rc;
+}
 
-    std::println("→ {}", build);
-    return std::system(build.c_str());
+static int build_cmake(bool release,
+                       bool force,
+                       const std::vector<std::string>& user_defines,
+                       dev::TaskState& state)
+{
+    auto type = release ? "Release" : "Debug";
+    std::vector<std::string> defines{std::string("-DCMAKE_BUILD_TYPE=") + type};
+    defines.insert(defines.end(), user_defines.begin(), user_defines.end());
+    std::string configure = "cmake -B build";
+    for (const auto& d : defines) {
+        configure += ' ' + d;
+    }
+
+    // The compilers' identity is read from CMakeCache.txt, so the
+    // fingerprint is taken after configure has (re)written it.
+    std::error_code ec;
+    bool configured = fs::exists(fs::path("build") / "CMakeCache.txt", ec);
+    if (!force && configured &&
+        state.matches("cmake-configure", cmake_fingerprint(configure, defines))) {
+        std::println("build: configure inputs unchanged, skipping `cmake -B build`");
+    } else {
+        if (int rc = run(configure); rc != 0) {
+            state.forget("cmake-configure");
+            state.save();
+            return rc;
+        }
+        state.record("cmake-configure", cmake_fingerprint(configure, defines));
+        state.save();
+    }
+    return run(std::string("cmake --build build --config ") + type);
 }
 
 static int build_cargo(bool release)
 {
-    std::string cmd = release ? "cargo build --release" : "cargo build";
-    std::println("→ {}", cmd);
-    return std::system(cmd.c_str());
+    return run(release ? "cargo build --release" : "cargo build");
 }
 
-static int build_npm([[maybe_unused]] bool release)
+static int build_npm([[maybe_unused]] bool release, bool force, dev::TaskState& state)
 {
-    std::println("→ npm run build");
-    return std::system("npm run build");
+    std::string cmd = "npm run build";
+    return run_step(cmd, "npm", npm_fingerprint(cmd), npm_outputs, force, state);
 }
 
-static int build_make([[maybe_unused]] bool release)
+static int build_make([[maybe_unused]] bool release, bool force)
 {
-    std::println("→ make");
-    return std::system("make");
+    // Make tracks its own dependencies: -q runs nothing and exits 0 when
+    // the default target is up to date.
+#ifdef _WIN32
+    constexpr const char* query = "make -q >NUL 2>&1";
+#else
+    constexpr const char* query = "make -q >/dev/null 2>&1";
+#endif
+    if (!force && std::system(query) == 0) {
+        std::println("build: make -q reports everything up to date, skipping `make`");
+        return 0;
+    }
+    return run("make");
 }
 
 static int build_go([[maybe_unused]] bool release)
 {
-    std::println("→ go build ./...");
-    return std::system("go build ./...");
+    return run("go build ./...");
 }
 
-int main(int argc, char* argv[])
+static int build_main(int argc, char* argv[])
 {
     if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
         std::println("build — auto-detect build system and build");
         std::println("");
-        std::println("usage: dev build [--release]");
+        std::println("usage: dev build [--release] [--force] [-D<var>=<value>...]");
+        std::println("");
+        std::println("options:");
+        std::println("  -r, --release   release build");
+        std::println("  -f, --force     run every step, even if nothing changed");
+        std::println("  -D<var>=<val>   passed to the CMake configure step");
         std::println("");
         std::println("supported: CMake, Cargo, npm, Make, Go");
+        std::println("");
+        std::println("The CMake configure step and npm builds are skipped when their");
+        std::println("inputs are unchanged since the last successful run (hashes in");
+        std::println(".dev/build.state).  npm inputs: [build] inputs in dev.toml, else");
+        std::println("top-level files plus src/, public/, app/, pages/, ... .");
         return 0;
     }
 
+    // Join the trace of `dev --trace=<file>`, if any; run() adds the spans.
+    dev::trace::attach_from_env("build");
+
     bool release = false;
+    bool force = false;
+    std::vector<std::string> defines;
     for (int i = 1; i < argc; ++i) {
-        if (std::string_view(argv[i]) == "--release" || std::string_view(argv[i]) == "-r") {
+        std::string_view arg = argv[i];
+        if (arg == "--release" || arg == "-r") {
             release = true;
+        } else if (arg == "--force" || arg == "-f") {
+            force = true;
+        } else if (arg.starts_with("-D") && arg.size() > 2) {
+            defines.emplace_back(arg);
         }
     }
 
@@ -126,19 +462,20 @@ int main(int argc, char* argv[])
     std::println("build: detected {} project", name_of(bs));
     std::println("");
 
+    dev::TaskState state(fs::path(".dev") / "build.state");
     int rc = 0;
     switch (bs) {
         case BuildSystem::CMake:
-            rc = build_cmake(release);
+            rc = build_cmake(release, force, defines, state);
             break;
         case BuildSystem::Cargo:
             rc = build_cargo(release);
             break;
         case BuildSystem::Npm:
-            rc = build_npm(release);
+            rc = build_npm(release, force, state);
             break;
         case BuildSystem::Make:
-            rc = build_make(release);
+            rc = build_make(release, force);
             break;
         case BuildSystem::Go:
             rc = build_go(release);
@@ -153,3 +490,10 @@ int main(int argc, char* argv[])
     }
     return rc;
 }
+
+DEV_PLUGIN_MAIN(build_main, "build", "Auto-detect build system and build", "1.0.0")
+DEV_PLUGIN_META("build",
+                "Auto-detect build system and build",
+                "1.0.0",
+                "",
+                "--release -r --force -f --help")
@@ -5,6 +5,8 @@
  * Usage:  dev clean
  */
 
+#include "dev/plugin.hpp"
+
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -20,7 +22,7 @@ static void remove_dir(const char* name)
     }
 }
 
-int main(int argc, char* argv[])
+static int clean_main(int argc, char* argv[])
 {
     if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
         std::println("clean — remove build artifacts");
@@ -83,3 +85,6 @@ int main(int argc, char* argv[])
     std::println("✓ Clean completed");
     return 0;
 }
+
+DEV_PLUGIN_MAIN(clean_main, "clean", "Remove build artifacts", "1.0.0")
+DEV_PLUGIN_META("clean", "Remove build artifacts", "1.0.0", "", "--help")
@@ -3,119 +3,99 @@
  * @brief Plugin — generate shell completion scripts.
  *
  * Usage:  dev completion <bash|zsh|fish|pwsh>
+ *
+ * The scripts hold no command names: on every TAB they ask
+ * `dev __complete <cword> <words...>` (see dev/complete.hpp), so plugins,
+ * aliases and plugin arguments are always current.
  */
 
-#include <algorithm>
+#include "dev/plugin.hpp"
+
 #include <cstring>
-#include <filesystem>
 #include <print>
-#include <string>
 #include <string_view>
-#include <vector>
-
-namespace fs = std::filesystem;
 
-static std::vector<std::string> discover_plugins()
-{
-    std::vector<std::string> names;
-
-    // Check cwd/plugins (most common during dev)
-    fs::path dir = fs::current_path() / "plugins";
-    if (!fs::is_directory(dir))
-        return names;
+// Each script turns the shell's view of the command line into
+// `dev __complete <cword> <words...>` and its `word<TAB>description`
+// lines into candidates.  A missing answer falls back to file names.
 
-    for (const auto& entry : fs::directory_iterator(dir)) {
-        if (!entry.is_regular_file())
-            continue;
-        auto stem = entry.path().stem().string();
-        if (stem != "completion") { // don't complete ourselves
-            names.push_back(stem);
-        }
-    }
-    std::sort(names.begin(), names.end());
-    return names;
+static constexpr std::string_view bash_script = R"script(# Bash completion for dev
+# Add to ~/.bashrc:  eval "$(dev completion bash)"
+_dev_completions() {
+  # Split the line ourselves: COMP_WORDS breaks --opt=value apart.
+  local line=${COMP_LINE:0:COMP_POINT} cur c
+  local -a words
+  read -ra words <<< "$line"
+  local cword=${#words[@]}
+  [[ $line == *[[:space:]] ]] || cword=$((cword - 1))
+  cur=${words[cword]}
+  COMPREPLY=()
+  while IFS=$'\t' read -r c _; do
+    # Bash replaces only the text after the last '='.
+    [[ $cur == *=* && $COMP_WORDBREAKS == *=* ]] && c=${c#"${cur%=*}="}
+    COMPREPLY+=("$c")
+  done < <(dev __complete "$cword" "${words[@]}" 2>/dev/null)
+  [[ ${#COMPREPLY[@]} -eq 1 && ${COMPREPLY[0]} == *= ]] && compopt -o nospace
 }
+complete -o default -F _dev_completions dev
+)script";
 
-static std::string join_space(const std::vector<std::string>& v)
-{
-    std::string s;
-    for (const auto& x : v) {
-        if (!s.empty())
-            s += ' ';
-        s += x;
-    }
-    return s;
+static constexpr std::string_view zsh_script = R"script(# Zsh completion for dev
+# Add to ~/.zshrc:  eval "$(dev completion zsh)"
+_dev() {
+  local -a candidates
+  local line
+  for line in "${(@f)$(dev __complete $((CURRENT - 1)) "${words[@]}" 2>/dev/null)}"; do
+    [[ -z $line ]] && continue
+    if [[ $line == *$'\t'* ]]; then
+      candidates+=("${${line%%$'\t'*}//:/\\:}:${line#*$'\t'}")
+    else
+      candidates+=("${line//:/\\:}")
+    fi
+  done
+  if (( ${#candidates} )); then
+    _describe -t dev 'dev' candidates
+  else
+    _files
+  fi
 }
+compdef _dev dev
+)script";
 
-static void gen_bash(const std::vector<std::string>& plugins)
-{
-    auto cmds = join_space(plugins);
-    std::println("# Bash completion for dev");
-    std::println("# Add to ~/.bashrc:  eval \"$(dev completion bash)\"");
-    std::println("_dev_completions() {{");
-    std::println("  local cur=${{COMP_WORDS[COMP_CWORD]}}");
-    std::println("  if [[ $COMP_CWORD -eq 1 ]]; then");
-    std::println("    COMPREPLY=($(compgen -W \"{} list help --help --version\" "
-                 "-- \"$cur\"))",
-                 cmds);
-    std::println("  fi");
-    std::println("}}");
-    std::println("complete -F _dev_completions dev");
-}
+static constexpr std::string_view fish_script = R"script(# Fish completion for dev
+# Save as ~/.config/fish/completions/dev.fish
+function __dev_complete
+    set -l tokens (commandline -opc) (commandline -ct)
+    set -l out (dev __complete (math (count $tokens) - 1) $tokens 2>/dev/null)
+    if test (count $out) -gt 0
+        printf '%s\n' $out
+    else
+        __fish_complete_path (commandline -ct)
+    end
+end
+complete -c dev -e
+complete -c dev -f -a '(__dev_complete)'
+)script";
 
-static void gen_zsh(const std::vector<std::string>& plugins)
-{
-    std::println("# Zsh completion for dev");
-    std::println("# Add to ~/.zshrc:  eval \"$(dev completion zsh)\"");
-    std::println("_dev() {{");
-    std::println("  local -a commands=(");
-    for (const auto& p : plugins) {
-        std::println("    '{}'", p);
-    }
-    std::println("    'list' 'help' '--help' '--version'");
-    std::println("  )");
-    std::println("  _arguments '1:command:compadd -a commands' '*:file:_files'");
-    std::println("}}");
-    std::println("compdef _dev dev");
-}
-
-static void gen_fish(const std::vector<std::string>& plugins)
-{
-    std::println("# Fish completion for dev");
-    std::println("# Add to ~/.config/fish/completions/dev.fish");
-    std::println("complete -c dev -e");
-    for (const auto& p : plugins) {
-        std::println("complete -c dev -n '__fish_use_subcommand' -a '{}' -d 'Plugin'", p);
-    }
-    std::println("complete -c dev -n '__fish_use_subcommand' -a 'list' -d 'List "
-                 "available commands'");
-    std::println("complete -c dev -n '__fish_use_subcommand' -a 'help' -d 'Show "
-                 "help for a command'");
-    std::println("complete -c dev -n '__fish_use_subcommand' -l 'help' -d 'Show help'");
-    std::println("complete -c dev -n '__fish_use_subcommand' -l 'version' -d "
-                 "'Show version'");
+static constexpr std::string_view pwsh_script = R"script(# PowerShell completion for dev
+# Add to $PROFILE:  dev completion pwsh | Invoke-Expression
+Register-ArgumentCompleter -CommandName dev -Native -ScriptBlock {
+  param($wordToComplete, $commandAst, $cursorPosition)
+  $words = @($commandAst.CommandElements |
+    Where-Object { $_.Extent.StartOffset -lt $cursorPosition } |
+    ForEach-Object { $_.ToString() })
+  # Empty arguments are dropped by older PowerShell: a cursor after the
+  # last word is cword == count instead.
+  $cword = if ($wordToComplete) { $words.Count - 1 } else { $words.Count }
+  dev __complete $cword @words 2>$null | ForEach-Object {
+    $word, $desc = $_ -split "`t", 2
+    if (-not $desc) { $desc = $word }
+    [System.Management.Automation.CompletionResult]::new($word, $word, 'ParameterValue', $desc)
+  }
 }
+)script";
 
-static void gen_pwsh(const std::vector<std::string>& plugins)
-{
-    std::println("# PowerShell completion for dev");
-    std::println("# Add to $PROFILE:  dev completion pwsh | Invoke-Expression");
-    std::println("Register-ArgumentCompleter -CommandName dev -Native -ScriptBlock {{");
-    std::println("  param($wordToComplete, $commandAst, $cursorPosition)");
-    std::println("  $commands = @(");
-    for (const auto& p : plugins) {
-        std::println("    '{}'", p);
-    }
-    std::println("    'list'; 'help'; '--help'; '--version'");
-    std::println("  )");
-    std::println("  $commands | Where-Object {{ $_ -like \"$wordToComplete*\" }} |");
-    std::println("    ForEach-Object {{ "
-                 "[System.Management.Automation.CompletionResult]::new($_, $_, "
-                 "'ParameterValue', $_) }}");
-    std::println("}}");
-}
-
-int main(int argc, char* argv[])
+static int completion_main(int argc, char* argv[])
 {
     if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
         std::println("completion — generate shell completion scripts");
@@ -136,17 +116,16 @@ int main(int argc, char* argv[])
         return (argc < 2) ? 2 : 0;
     }
 
-    auto plugins = discover_plugins();
     std::string_view shell = argv[1];
 
     if (shell == "bash")
-        gen_bash(plugins);
+        std::print("{}", bash_script);
     else if (shell == "zsh")
-        gen_zsh(plugins);
+        std::print("{}", zsh_script);
     else if (shell == "fish")
-        gen_fish(plugins);
+        std::print("{}", fish_script);
     else if (shell == "pwsh")
-        gen_pwsh(plugins);
+        std::print("{}", pwsh_script);
     else {
         std::println(stderr, "completion: unknown shell '{}'", shell);
         std::println(stderr, "  supported: bash, zsh, fish, pwsh");
@@ -155,3 +134,13 @@ int main(int argc, char* argv[])
 
     return 0;
 }
+
+DEV_PLUGIN_MAIN(completion_main,
+                "completion",
+                "Generate shell completion scripts",
+                "1.0.0")
+DEV_PLUGIN_META("completion",
+                "Generate shell completion scripts",
+                "1.0.0",
+                "",
+                "bash zsh fish pwsh --help")
@@ -5,6 +5,8 @@
  * Usage:  dev create <name> [--template cpp|c|py]
  */
 
+#include "dev/plugin.hpp"
+
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -147,7 +149,7 @@ static void scaffold_py(const fs::path& root, std::string_view name)
 
 // ── Main ─────────────────────────────────────────────────────
 
-int main(int argc, char* argv[])
+static int create_main(int argc, char* argv[])
 {
     if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
         std::println("create — scaffold a new project");
@@ -194,3 +196,10 @@ int main(int argc, char* argv[])
     std::println("✓ Created '{}' project: {}", tmpl, root.string());
     return 0;
 }
+
+DEV_PLUGIN_MAIN(create_main, "create", "Scaffold a new project from a template", "1.0.0")
+DEV_PLUGIN_META("create",
+                "Scaffold a new project from a template",
+                "1.0.0",
+                "",
+                "--template=cpp|c|py -t=cpp|c|py --help")
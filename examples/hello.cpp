@@ -3,12 +3,19 @@
  * @brief Example plugin — prints a greeting.
  *
  * Usage:  dev hello [name]
+ *
+ * Built as a plain executable by default.  With -DDEV_SHARED_PLUGINS=ON it
+ * becomes a shared-library plugin (see dev/plugin.hpp), and with
+ * -DDEV_MULTICALL=ON it is compiled into dev itself; either way
+ * `dev hello` then runs without a fork or exec.
  */
 
+#include "dev/plugin.hpp"
+
 #include <cstring>
 #include <print>
 
-int main(int argc, char* argv[])
+static int hello_main(int argc, char* argv[])
 {
     if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
         std::println("hello — greet someone (or the world)");
@@ -25,3 +32,6 @@ int main(int argc, char* argv[])
     std::println("Hello, {}!", name);
     return 0;
 }
+
+DEV_PLUGIN_MAIN(hello_main, "hello", "Greet someone (or the world)", "1.0.0")
+DEV_PLUGIN_META("hello", "Greet someone (or the world)", "1.0.0", "", "--help")
@@ -5,6 +5,8 @@
  * Usage:  dev init-plugin <name>
  */
 
+#include "dev/plugin.hpp"
+
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -20,7 +22,7 @@ static void write_file(const fs::path& path, std::string_view content)
     ofs << content;
 }
 
-int main(int argc, char* argv[])
+static int init_plugin_main(int argc, char* argv[])
 {
     if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
         std::println("init-plugin — scaffold a new dev plugin");
@@ -29,7 +31,7 @@ int main(int argc, char* argv[])
         std::println("");
         std::println("creates:");
         std::println("  <name>/");
-        std::println("  ├── <name>.cpp          main source with --help boilerplate");
+        std::println("  ├── <name>.cpp          main source with --help and DEV_PLUGIN_META");
         std::println("  ├── CMakeLists.txt      standalone build file");
         std::println("  └── README.md           plugin documentation");
         return (argc < 2) ? 2 : 0;
@@ -64,6 +66,17 @@ int main(int argc, char* argv[])
                    "#include <print>\n"
                    "#include <string_view>\n"
                    "\n"
+                   "// Metadata dev reads from the binary without running it.\n"
+                   "#if __has_include(<dev/plugin.hpp>)\n"
+                   "#include <dev/plugin.hpp>\n"
+                   "#else\n"
+                   "#define DEV_PLUGIN_META(name, description, version, flags, completion)\n"
+                   "#endif\n"
+                   "\n"
+                   "DEV_PLUGIN_META(\"" +
+                   name +
+                   "\", \"<description>\", \"0.1.0\", \"\", \"--help\")\n"
+                   "\n"
                    "int main(int argc, char* argv[]) {\n"
                    "\tif (argc > 1 && std::strcmp(argv[1], \"--help\") == 0) {\n"
                    "\t\tstd::println(\"" +
@@ -101,6 +114,13 @@ int main(int argc, char* argv[])
                    name +
                    ".cpp)\n"
                    "\n"
+                   "# dev's include/ dir, for dev/plugin.hpp (DEV_PLUGIN_META):\n"
+                   "#   cmake -B build -DDEV_INCLUDE_DIR=<path-to-dev>/include\n"
+                   "set(DEV_INCLUDE_DIR \"\" CACHE PATH \"dev include directory\")\n"
+                   "if(DEV_INCLUDE_DIR)\n"
+                   "\ttarget_include_directories(${PROJECT_NAME} PRIVATE ${DEV_INCLUDE_DIR})\n"
+                   "endif()\n"
+                   "\n"
                    "# Install to dev plugins directory:\n"
                    "#   cmake --install build --prefix <path-to-dev>/plugins\n"
                    "install(TARGETS ${PROJECT_NAME} RUNTIME DESTINATION .)\n");
@@ -115,7 +135,8 @@ int main(int argc, char* argv[])
                    "## Build\n"
                    "\n"
                    "```bash\n"
-                   "cmake -B build -DCMAKE_BUILD_TYPE=Release\n"
+                   "cmake -B build -DCMAKE_BUILD_TYPE=Release \\\n"
+                   "    -DDEV_INCLUDE_DIR=/path/to/dev/include\n"
                    "cmake --build build --config Release\n"
                    "```\n"
                    "\n"
@@ -143,3 +164,9 @@ int main(int argc, char* argv[])
     std::println("  cp build/{}.exe ../plugins/", name);
     return 0;
 }
+
+DEV_PLUGIN_MAIN(init_plugin_main,
+                "init-plugin",
+                "Scaffold a new dev plugin project",
+                "1.0.0")
+DEV_PLUGIN_META("init-plugin", "Scaffold a new dev plugin project", "1.0.0", "", "--help")
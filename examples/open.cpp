@@ -5,6 +5,8 @@
  * Usage:  dev open [path]
  */
 
+#include "dev/plugin.hpp"
+
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -46,7 +48,7 @@ static bool try_editor(std::string_view editor, const fs::path& target)
     return true;
 }
 
-int main(int argc, char* argv[])
+static int open_main(int argc, char* argv[])
 {
     if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
         std::println("open — open a directory in your editor");
@@ -79,3 +81,6 @@ int main(int argc, char* argv[])
     std::println("✓ Opened with {}", fallback);
     return 0;
 }
+
+DEV_PLUGIN_MAIN(open_main, "open", "Open a directory in your editor/IDE", "1.0.0")
+DEV_PLUGIN_META("open", "Open a directory in your editor/IDE", "1.0.0", "", "--help")
@@ -5,6 +5,8 @@
  * Usage:  dev run [args...]
  */
 
+#include "dev/plugin.hpp"
+
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -152,7 +154,7 @@ static int run_go(const std::string& args)
     return std::system(cmd.c_str());
 }
 
-int main(int argc, char* argv[])
+static int run_main(int argc, char* argv[])
 {
     if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
         std::println("run — auto-detect build system and run the project");
@@ -189,3 +191,6 @@ int main(int argc, char* argv[])
             return 1;
     }
 }
+
+DEV_PLUGIN_MAIN(run_main, "run", "Auto-detect build system and run the project", "1.0.0")
+DEV_PLUGIN_META("run", "Auto-detect build system and run the project", "1.0.0", "", "--help")
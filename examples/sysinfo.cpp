@@ -5,10 +5,12 @@
  * Usage:  dev sysinfo
  */
 
+#include "dev/plugin.hpp"
+
 #include <filesystem>
 #include <print>
 
-int main(int argc, char* argv[])
+static int sysinfo_main(int argc, char* argv[])
 {
     if (argc > 1 && std::string_view(argv[1]) == "--help") {
         std::println("sysinfo — display basic system information");
@@ -50,3 +52,6 @@ int main(int argc, char* argv[])
     std::println("");
     return 0;
 }
+
+DEV_PLUGIN_MAIN(sysinfo_main, "sysinfo", "Display basic system information", "1.0.0")
+DEV_PLUGIN_META("sysinfo", "Display basic system information", "1.0.0", "", "--help")
@@ -5,10 +5,28 @@
 
 #pragma once
 
+#include "dev/cache.hpp"
+#include "dev/complete.hpp"
 #include "dev/config.hpp"
+#include "dev/daemon.hpp"
 #include "dev/dispatcher.hpp"
 #include "dev/error.hpp"
+#include "dev/helpcache.hpp"
+#include "dev/hooks.hpp"
+#include "dev/index.hpp"
+#include "dev/jobserver.hpp"
+#include "dev/loader.hpp"
+#include "dev/mmap.hpp"
+#include "dev/multicall.hpp"
+#include "dev/output.hpp"
+#include "dev/parallel.hpp"
+#include "dev/pipeline.hpp"
+#include "dev/plugin.hpp"
+#include "dev/plugin_meta.hpp"
 #include "dev/process.hpp"
 #include "dev/style.hpp"
+#include "dev/suggest.hpp"
+#include "dev/tasks.hpp"
+#include "dev/trace.hpp"
 #include "dev/version.hpp"
 
@@ -0,0 +1,172 @@
+/**
+ * @file cache.hpp
+ * @brief Helpers shared by dev's on-disk caches: cache directory,
+ *        file identity stamps, hashing, and atomic replacement.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+// ── Location ────────────────────────────────────────────────
+
+/// Directory for dev's caches.  Order: $DEV_CACHE_DIR → platform default
+/// (%LOCALAPPDATA%/dev/cache, $XDG_CACHE_HOME/dev, ~/.cache/dev).
+/// Returns an empty path if none can be determined.
+inline fs::path cache_dir()
+{
+    if (const char* dir = std::getenv("DEV_CACHE_DIR"); dir && *dir) {
+        return dir;
+    }
+#ifdef _WIN32
+    if (const char* local = std::getenv("LOCALAPPDATA")) {
+        return fs::path(local) / "dev" / "cache";
+    }
+    return {};
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return fs::path(xdg) / "dev";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return fs::path(home) / ".cache" / "dev";
+    }
+    return {};
+#endif
+}
+
+// ── Identity ────────────────────────────────────────────────
+
+/// Identity of a file or directory as seen by stat().  Two equal stamps
+/// mean "unchanged" for cache purposes.  All-zero = does not exist.
+struct FileStamp
+{
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+    std::uint64_t size = 0;
+    std::uint64_t mtime_ns = 0;
+
+    friend bool operator==(const FileStamp&, const FileStamp&) = default;
+};
+
+#ifndef _WIN32
+/// Stamp from a stat() / fstat() result.
+inline FileStamp stamp_of(const struct stat& st)
+{
+    FileStamp s;
+    s.dev = static_cast<std::uint64_t>(st.st_dev);
+    s.ino = static_cast<std::uint64_t>(st.st_ino);
+    s.size = static_cast<std::uint64_t>(st.st_size);
+#ifdef __APPLE__
+    s.mtime_ns = static_cast<std::uint64_t>(st.st_mtimespec.tv_sec) * 1'000'000'000u +
+                 static_cast<std::uint64_t>(st.st_mtimespec.tv_nsec);
+#else
+    s.mtime_ns = static_cast<std::uint64_t>(st.st_mtim.tv_sec) * 1'000'000'000u +
+                 static_cast<std::uint64_t>(st.st_mtim.tv_nsec);
+#endif
+    return s;
+}
+#endif
+
+inline FileStamp stamp_of(const fs::path& path)
+{
+    FileStamp s;
+#ifdef _WIN32
+    std::error_code ec;
+    auto t = fs::last_write_time(path, ec);
+    if (ec) {
+        return s;
+    }
+    s.mtime_ns = static_cast<std::uint64_t>(t.time_since_epoch().count());
+    if (fs::is_regular_file(path, ec)) {
+        s.size = static_cast<std::uint64_t>(fs::file_size(path, ec));
+    }
+#else
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) {
+        return s;
+    }
+    s = stamp_of(st);
+#endif
+    return s;
+}
+
+// ── Hashing ─────────────────────────────────────────────────
+
+/// 64-bit FNV-1a.  Pass a previous result as `h` to hash incrementally.
+constexpr std::uint64_t fnv1a64(std::string_view data, std::uint64_t h = 0xcbf29ce484222325ull)
+{
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/// Fixed-width lowercase hex, for cache file names.
+inline std::string to_hex(std::uint64_t v)
+{
+    constexpr const char* digits = "0123456789abcdef";
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        out[static_cast<std::size_t>(i)] = digits[v & 0xf];
+        v >>= 4;
+    }
+    return out;
+}
+
+// ── Atomic replace ──────────────────────────────────────────
+
+/// Write `bytes` to `path` via a temporary file + rename, so concurrent
+/// readers see either the old or the new content — never a torn file.
+inline bool write_atomic(const fs::path& path, std::string_view bytes)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+#ifdef _WIN32
+    auto pid = _getpid();
+#else
+    auto pid = getpid();
+#endif
+    fs::path tmp = path;
+    tmp += ".tmp." + std::to_string(pid);
+
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            return false;
+        }
+        ofs.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!ofs) {
+            ofs.close();
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace dev
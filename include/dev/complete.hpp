@@ -0,0 +1,160 @@
+/**
+ * @file complete.hpp
+ * @brief Shell-independent command-line completion (`dev __complete`).
+ *
+ * The scripts printed by `dev completion <shell>` contain no command
+ * names: on every TAB they run
+ *
+ *     dev __complete <cword> <words...>
+ *
+ * with the words of the command line (words[0] is `dev`) and the index
+ * of the word under the cursor, which may be one past the last word.
+ * dev answers with one candidate per line, `word` or
+ * `word<TAB>description`, taken from the plugin index (mmap), the config
+ * and the plugins' own completion specs — no plugin is run.
+ *
+ * A completion spec (DEV_PLUGIN_META or `completion` in plugins.toml)
+ * is a space-separated list of words offered after the command:
+ *
+ *     --release -r            plain words
+ *     --template=cpp|c|py     an option taking one of these values, as
+ *                             `--template cpp` or `--template=cpp`
+ */
+
+#pragma once
+
+#include "dev/output.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dev {
+
+/// Candidates for the word under the cursor.  Words not starting with
+/// what has been typed so far are dropped on add().
+class Completions
+{
+public:
+    explicit Completions(std::string_view current)
+        : current_(current)
+    {
+    }
+
+    /// The (partial) word being completed.
+    [[nodiscard]] std::string_view current() const
+    {
+        return current_;
+    }
+
+    void add(std::string_view word, std::string_view description = {})
+    {
+        if (word.starts_with(current_)) {
+            items_.push_back({std::string(word), description});
+        }
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return items_.empty();
+    }
+
+    /// One candidate per line, sorted; for a word offered twice (a plugin
+    /// also bundled, say) the first description wins.
+    void write(OutputBuffer& out)
+    {
+        std::stable_sort(items_.begin(), items_.end(), [](const Item& a, const Item& b) {
+            return a.word < b.word;
+        });
+        std::string_view last;
+        bool first = true;
+        for (const auto& it : items_) {
+            if (!first && it.word == last) {
+                continue;
+            }
+            first = false;
+            last = it.word;
+            if (it.description.empty()) {
+                out.println("{}", it.word);
+            } else {
+                // A tab or newline inside the description would split the line.
+                std::string_view d = it.description.substr(0, it.description.find_first_of("\t\n"));
+                out.println("{}\t{}", it.word, d);
+            }
+        }
+    }
+
+private:
+    struct Item
+    {
+        std::string word;
+        std::string_view description;
+    };
+
+    std::string_view current_;
+    std::vector<Item> items_;
+};
+
+/// Offer the arguments of a completion `spec` (see above).  `previous` is
+/// the word before the cursor: after an option that takes values only
+/// those values are offered.
+inline void complete_spec(std::string_view spec, std::string_view previous, Completions& out)
+{
+    // Calls fn(option, values) per spec word; values is empty for a plain word.
+    auto each = [&](auto&& fn) {
+        std::string_view rest = spec;
+        while (!rest.empty()) {
+            auto end = rest.find(' ');
+            auto word = rest.substr(0, end);
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+            if (word.empty()) {
+                continue;
+            }
+            auto eq = word.find('=');
+            if (eq == std::string_view::npos) {
+                fn(word, std::string_view{});
+            } else {
+                fn(word.substr(0, eq), word.substr(eq + 1));
+            }
+        }
+    };
+    auto each_value = [](std::string_view values, auto&& fn) {
+        while (!values.empty()) {
+            auto bar = values.find('|');
+            fn(values.substr(0, bar));
+            values.remove_prefix(bar == std::string_view::npos ? values.size() : bar + 1);
+        }
+    };
+
+    // `--template <TAB>`
+    bool takes_value = false;
+    each([&](std::string_view option, std::string_view values) {
+        if (option == previous && !values.empty()) {
+            takes_value = true;
+            each_value(values, [&](std::string_view v) { out.add(v); });
+        }
+    });
+    if (takes_value) {
+        return;
+    }
+
+    // `--template=c<TAB>`
+    auto current = out.current();
+    if (auto eq = current.find('='); eq != std::string_view::npos) {
+        auto typed = current.substr(0, eq);
+        each([&](std::string_view option, std::string_view values) {
+            if (option == typed) {
+                each_value(values, [&](std::string_view v) {
+                    out.add(std::string(option) + "=" + std::string(v));
+                });
+            }
+        });
+        return;
+    }
+
+    each([&](std::string_view option, std::string_view) { out.add(option); });
+}
+
+} // namespace dev
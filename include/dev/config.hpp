@@ -9,13 +9,39 @@
  *   key = ["a", "b", "c"]
  *   [section]
  *   key = value
+ *
+ * The file is memory-mapped and parsed in a single pass.  Keys, values
+ * and list items are string_views into the mapping, which all copies of a
+ * Config share, so loading allocates per section rather than per line.
+ * A (section, key) lookup hashes the two parts as if joined by a dot —
+ * `get("a", "b.c")` still finds `[a.b] c` — without building the string,
+ * and each section's entries are one contiguous span.
+ *
+ * Files of `compile_threshold` bytes or more are also compiled into a
+ * binary image in the cache dir: the text, the entry/item/section tables
+ * as offsets, and a perfect-hash table over (section, key).  The image is
+ * keyed by the source's absolute path and validated against its stamp
+ * (dev/inode/size/mtime) and the format version; loading it is one
+ * mapping, a constant number of allocations and no parsing.  A stale,
+ * foreign or truncated image is ignored and rewritten atomically, so
+ * concurrent processes at worst compile the same file twice.
+ * `DEV_NO_CONFIG_CACHE` disables it.
  */
 
 #pragma once
 
+#include "dev/cache.hpp"
+#include "dev/mmap.hpp"
+#include "dev/self.hpp"
+
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -31,42 +57,148 @@ class Config
     using Map = std::unordered_map<std::string, std::string>;
     using List = std::unordered_map<std::string, std::vector<std::string>>;
 
+    /// One `key = value` or `key = [...]` line.  Views into the file.
+    struct Entry
+    {
+        std::string_view section;
+        std::string_view key;
+        std::string_view value;         ///< scalar value (empty for a list)
+        std::uint32_t first_item = 0;   ///< list: first item in items()
+        std::uint32_t item_count = 0;   ///< list: number of items
+        bool is_list = false;
+    };
+
+    // ── Zero-copy lookups ───────────────────────────────────
+    //
+    // Views stay valid as long as this Config or any copy of it.
+
+    /// Scalar value, or nullopt if there is none.
+    [[nodiscard]] std::optional<std::string_view> value(std::string_view section,
+                                                        std::string_view key) const
+    {
+        const Entry* e = find_entry(section, key);
+        if (!e || e->is_list) {
+            return std::nullopt;
+        }
+        return e->value;
+    }
+
+    /// Array items (empty if there is no such array).
+    [[nodiscard]] std::span<const std::string_view> list(std::string_view section,
+                                                         std::string_view key) const
+    {
+        const Entry* e = find_entry(section, key);
+        if (!e || !e->is_list) {
+            return {};
+        }
+        return std::span(items_).subspan(e->first_item, e->item_count);
+    }
+
+    /// Entries under `[name]` ("" = before the first header), in file
+    /// order, one per key (the last assignment wins).
+    [[nodiscard]] std::span<const Entry> section(std::string_view name) const
+    {
+        auto it = std::lower_bound(sections_.begin(),
+                                   sections_.end(),
+                                   name,
+                                   [](const SectionRange& r, std::string_view n) {
+                                       return r.name < n;
+                                   });
+        if (it == sections_.end() || it->name != name) {
+            return {};
+        }
+        return std::span(entries_).subspan(it->begin, it->end - it->begin);
+    }
+
+    /// Items of a list entry.
+    [[nodiscard]] std::span<const std::string_view> items(const Entry& e) const
+    {
+        return std::span(items_).subspan(e.first_item, e.item_count);
+    }
+
+    // ── Copying accessors ───────────────────────────────────
+
     /// Get a scalar value.  Returns fallback if not found.
     [[nodiscard]] std::string
     get(const std::string& section, const std::string& key, const std::string& fallback = {}) const
     {
-        auto full = section.empty() ? key : section + "." + key;
-        auto it = values_.find(full);
-        return (it != values_.end()) ? it->second : fallback;
+        auto v = value(section, key);
+        return v ? std::string(*v) : fallback;
     }
 
     /// Get an array value.  Returns empty vector if not found.
     [[nodiscard]] std::vector<std::string> get_list(const std::string& section,
                                                     const std::string& key) const
     {
-        auto full = section.empty() ? key : section + "." + key;
-        auto it = lists_.find(full);
-        return (it != lists_.end()) ? it->second : std::vector<std::string>{};
+        auto items = list(section, key);
+        return {items.begin(), items.end()};
     }
 
-    /// Get all key-value pairs inside a section.
+    /// Get a boolean value ("true"/"yes"/"on"/"1").  Returns fallback if not found.
+    [[nodiscard]] bool
+    get_bool(const std::string& section, const std::string& key, bool fallback = false) const
+    {
+        auto v = value(section, key).value_or("");
+        if (v.empty()) {
+            return fallback;
+        }
+        return v == "true" || v == "yes" || v == "on" || v == "1";
+    }
+
+    /// Get all key-value pairs inside a section (including dotted keys of
+    /// nested sections, e.g. `[a.b] c` as "b.c" of "a").
     [[nodiscard]] std::unordered_map<std::string, std::string>
     get_section(const std::string& section) const
     {
         std::unordered_map<std::string, std::string> result;
         const std::string prefix = section + ".";
-        for (const auto& [k, v] : values_) {
-            if (k.starts_with(prefix)) {
-                result[k.substr(prefix.size())] = v;
+        for (const auto& r : sections_) {
+            if (r.name == section) {
+                for (const auto& e : entries(r)) {
+                    if (!e.is_list) {
+                        result[std::string(e.key)] = e.value;
+                    }
+                }
+            } else if (related(r.name, section)) {
+                for (const auto& e : entries(r)) {
+                    auto full = flat_name(e);
+                    if (!e.is_list && full.starts_with(prefix)) {
+                        result[full.substr(prefix.size())] = e.value;
+                    }
+                }
             }
         }
         return result;
     }
 
+    /// Names of the `[parent.<name>]` sections, sorted ("tasks" → build, test).
+    [[nodiscard]] std::vector<std::string> subsections(const std::string& parent) const
+    {
+        std::vector<std::string> names;
+        const std::string prefix = parent + ".";
+        for (const auto& r : sections_) {
+            if (r.name == parent || related(r.name, parent)) {
+                for (const auto& e : entries(r)) {
+                    auto full = flat_name(e);
+                    if (!full.starts_with(prefix)) {
+                        continue;
+                    }
+                    auto dot = full.find('.', prefix.size());
+                    if (dot != std::string::npos) {
+                        names.push_back(full.substr(prefix.size(), dot - prefix.size()));
+                    }
+                }
+            }
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        return names;
+    }
+
     /// Whether any configuration was loaded.
     [[nodiscard]] bool empty() const
     {
-        return values_.empty() && lists_.empty();
+        return entries_.empty();
     }
 
     /// Path of the loaded config file (empty if none).
@@ -77,106 +209,536 @@ class Config
 
     // ── Factory ─────────────────────────────────────────────
 
-    /// Parse a config file.  Returns an empty Config on failure.
-    static Config load(const fs::path& filepath)
+    /// Smaller files are always parsed: below this, the text parse costs
+    /// less than opening and validating a compiled image.
+    static constexpr std::size_t compile_threshold = 8 * 1024;
+
+    /// Parse a config file, or attach its compiled image if that is
+    /// current (see above; `use_cache = false` always parses).  Returns
+    /// an empty Config on failure.
+    static Config load(const fs::path& filepath, bool use_cache = true)
     {
         Config cfg;
-        std::ifstream ifs(filepath);
-        if (!ifs.is_open()) {
+        FileStamp stamp;
+        auto mapped = MappedFile::open(filepath, &stamp);
+        if (!mapped.is_open()) {
             return cfg;
         }
-
         cfg.path_ = filepath;
-        std::string section;
-        std::string line;
-
-        while (std::getline(ifs, line)) {
-            // Strip \r (Windows line endings)
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-
-            // Trim leading whitespace
-            auto start = line.find_first_not_of(" \t");
-            if (start == std::string::npos) {
-                continue;
-            }
-            line = line.substr(start);
-
-            // Skip comments and empty lines
-            if (line.empty() || line[0] == '#') {
-                continue;
-            }
 
-            // Section header: [name]
-            if (line.front() == '[' && line.back() == ']') {
-                section = line.substr(1, line.size() - 2);
-                continue;
+        fs::path image;
+        if (use_cache && mapped.size() >= compile_threshold &&
+            !std::getenv("DEV_NO_CONFIG_CACHE")) {
+            image = compiled_path(filepath);
+        }
+        if (!image.empty()) {
+            auto compiled = MappedFile::open(image);
+            if (!compiled.empty()) {
+                auto file = std::make_shared<const MappedFile>(std::move(compiled));
+                if (cfg.attach(*file, stamp)) {
+                    cfg.file_ = std::move(file);
+                    return cfg;
+                }
+                cfg = Config{};
+                cfg.path_ = filepath;
             }
+        }
 
-            // Key = value
-            auto eq = line.find('=');
-            if (eq == std::string::npos) {
-                continue;
-            }
-
-            auto key = trim(line.substr(0, eq));
-            auto val = trim(line.substr(eq + 1));
-            auto full_key = section.empty() ? key : section + "." + key;
-
-            // Array: ["a", "b", "c"]
-            if (val.starts_with("[")) {
-                cfg.lists_[full_key] = parse_array(val);
-            } else {
-                cfg.values_[full_key] = unquote(val);
+        auto file = std::make_shared<const MappedFile>(std::move(mapped));
+        cfg.parse(file->view());
+        cfg.file_ = std::move(file);
+        if (!image.empty()) {
+            if (auto bytes = cfg.compile(stamp); !bytes.empty()) {
+                write_atomic(image, bytes);
             }
         }
         return cfg;
     }
 
+    /// Whether this Config was served from a compiled image.
+    [[nodiscard]] bool from_cache() const
+    {
+        return phf_ != nullptr;
+    }
+
     /// Search for config file in standard locations.
-    /// Order: ./dev.toml → global config dir.
-    static Config find(const char* argv0 = nullptr)
+    /// Order: ./dev.toml → exe-relative dev.toml → global config dir.
+    /// Each candidate is simply opened: a miss costs one failed open(),
+    /// a hit needs no separate exists() probe.  `cwd` replaces the
+    /// process's working directory for the project-local lookup.
+    static Config find(const char* argv0 = nullptr, const fs::path& cwd = {})
     {
         // 1. Project-local
-        if (fs::exists("dev.toml")) {
-            return load("dev.toml");
+        if (auto cfg = load(cwd / "dev.toml"); !cfg.path_.empty()) {
+            return cfg;
         }
 
         // 1b. Exe-relative
         if (argv0) {
-            auto exe_dir = fs::weakly_canonical(fs::path(argv0)).parent_path();
-            auto p = exe_dir / "dev.toml";
-            if (fs::exists(p)) {
-                return load(p);
+            if (auto cfg = load(exe_dir(argv0) / "dev.toml"); !cfg.path_.empty()) {
+                return cfg;
             }
         }
 
         // 2. Global config
-        auto global = global_config_path();
-        if (fs::exists(global)) {
-            return load(global);
+        if (auto global = global_config_path(); !global.empty()) {
+            if (auto cfg = load(global); !cfg.path_.empty()) {
+                return cfg;
+            }
         }
 
         return {}; // No config found
     }
 
+    /// Location of the per-user config file (may not exist).
+    static fs::path global_config_path()
+    {
+#ifdef _WIN32
+        const char* appdata = std::getenv("APPDATA");
+        if (appdata) {
+            return fs::path(appdata) / "dev" / "config.toml";
+        }
+        return {};
+#else
+        const char* home = std::getenv("HOME");
+        if (home) {
+            return fs::path(home) / ".config" / "dev" / "config.toml";
+        }
+        return {};
+#endif
+    }
+
 private:
-    Map values_;
-    List lists_;
+    /// Entries [begin, end) of one section, sorted by name in sections_.
+    struct SectionRange
+    {
+        std::string_view name;
+        std::uint32_t begin = 0;
+        std::uint32_t end = 0;
+    };
+
+    std::shared_ptr<const MappedFile> file_; ///< owns the bytes all views point into
+    std::vector<Entry> entries_;             ///< grouped by section, file order inside
+    std::vector<std::string_view> items_;    ///< list items of all entries
+    std::vector<SectionRange> sections_;
+    std::vector<std::uint32_t> slots_;       ///< open-addressing index: entry + 1, 0 = free
     fs::path path_;
 
-    static std::string trim(std::string_view s)
+    // Compiled image: perfect-hash tables inside file_ (slots_ is unused).
+    const char* phf_ = nullptr; ///< u32 displacement[phf_buckets_], u32 slot[phf_mask_ + 1]
+    std::uint32_t phf_buckets_ = 0;
+    std::uint32_t phf_mask_ = 0;
+
+    std::span<const Entry> entries(const SectionRange& r) const
+    {
+        return std::span(entries_).subspan(r.begin, r.end - r.begin);
+    }
+
+    /// Whether keys of section `name` can spell names inside `section`
+    /// once flattened ("a.b" for "a", or "" / "a" for "a.b").
+    static bool related(std::string_view name, std::string_view section)
+    {
+        auto nested = [](std::string_view outer, std::string_view inner) {
+            return inner.size() > outer.size() && inner.starts_with(outer) &&
+                   inner[outer.size()] == '.';
+        };
+        return name.empty() || nested(section, name) || nested(name, section);
+    }
+
+    static std::string flat_name(const Entry& e)
+    {
+        if (e.section.empty()) {
+            return std::string(e.key);
+        }
+        std::string full;
+        full.reserve(e.section.size() + 1 + e.key.size());
+        full.append(e.section).append(".").append(e.key);
+        return full;
+    }
+
+    // ── Index ───────────────────────────────────────────────
+
+    /// FNV-1a of "section.key" (just "key" for the top level).
+    static std::uint64_t flat_hash(std::string_view section, std::string_view key)
+    {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        auto mix = [&h](std::string_view s) {
+            for (unsigned char c : s) {
+                h ^= c;
+                h *= 0x100000001b3ull;
+            }
+        };
+        if (!section.empty()) {
+            mix(section);
+            mix(".");
+        }
+        mix(key);
+        return h;
+    }
+
+    /// "s1.k1" == "s2.k2", without joining either.
+    static bool
+    flat_equal(std::string_view s1, std::string_view k1, std::string_view s2, std::string_view k2)
+    {
+        if (s1.size() == s2.size()) {
+            return s1 == s2 && k1 == k2;
+        }
+        auto length = [](std::string_view s, std::string_view k) {
+            return (s.empty() ? 0 : s.size() + 1) + k.size();
+        };
+        if (length(s1, k1) != length(s2, k2)) {
+            return false;
+        }
+        auto at = [](std::string_view s, std::string_view k, std::size_t i) {
+            if (s.empty()) {
+                return k[i];
+            }
+            if (i < s.size()) {
+                return s[i];
+            }
+            return i == s.size() ? '.' : k[i - s.size() - 1];
+        };
+        for (std::size_t i = 0, n = length(s1, k1); i < n; ++i) {
+            if (at(s1, k1, i) != at(s2, k2, i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Slot holding (section, key), or the free slot where it would go.
+    std::size_t probe(std::string_view section, std::string_view key) const
+    {
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = flat_hash(section, key) & mask;; i = (i + 1) & mask) {
+            auto slot = slots_[i];
+            if (slot == 0) {
+                return i;
+            }
+            const Entry& e = entries_[slot - 1];
+            if (flat_equal(e.section, e.key, section, key)) {
+                return i;
+            }
+        }
+    }
+
+    const Entry* find_entry(std::string_view section, std::string_view key) const
+    {
+        if (phf_) {
+            return find_compiled(section, key);
+        }
+        if (slots_.empty()) {
+            return nullptr;
+        }
+        auto slot = slots_[probe(section, key)];
+        return slot ? &entries_[slot - 1] : nullptr;
+    }
+
+    /// (Re)build the index over entries_ at a load factor of at most 1/2.
+    void rebuild_index()
+    {
+        std::size_t size = 8;
+        while (size < entries_.size() * 2) {
+            size *= 2;
+        }
+        slots_.assign(size, 0);
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            slots_[probe(entries_[i].section, entries_[i].key)] = static_cast<std::uint32_t>(i + 1);
+        }
+    }
+
+    // ── Compiled image ──────────────────────────────────────
+    //
+    // Layout (native endianness, string offsets relative to the text):
+    //
+    //   CompiledHeader
+    //   EntryRecord[entry_count]      — grouped by section, as entries_
+    //   ItemRecord[item_count]
+    //   SectionRecord[section_count]  — sorted by name, as sections_
+    //   u32 displacement[bucket_count]
+    //   u32 slot[slot_count]          — entry + 1, 0 = free
+    //   char text[text_size]          — the source file
+
+    static constexpr char compiled_magic[8] = {'D', 'E', 'V', 'C', 'F', 'G', '\0', '\0'};
+    static constexpr std::uint32_t compiled_version = 1;
+
+    struct CompiledHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entry_count;
+        std::uint32_t item_count;
+        std::uint32_t section_count;
+        std::uint32_t bucket_count;
+        std::uint32_t slot_count; ///< power of two
+        FileStamp source;
+        std::uint64_t text_size;
+    };
+
+    struct EntryRecord
+    {
+        std::uint32_t section_off;
+        std::uint32_t section_len;
+        std::uint32_t key_off;
+        std::uint32_t key_len;
+        std::uint32_t value_off;
+        std::uint32_t value_len;
+        std::uint32_t first_item;
+        std::uint32_t item_count;
+        std::uint32_t is_list;
+    };
+
+    struct ItemRecord
+    {
+        std::uint32_t off;
+        std::uint32_t len;
+    };
+
+    struct SectionRecord
+    {
+        std::uint32_t name_off;
+        std::uint32_t name_len;
+        std::uint32_t begin;
+        std::uint32_t end;
+    };
+
+    static fs::path compiled_path(const fs::path& source)
+    {
+        auto dir = cache_dir();
+        std::error_code ec;
+        auto abs = dir.empty() ? fs::path{} : fs::absolute(source, ec);
+        if (abs.empty() || ec) {
+            return {};
+        }
+        return dir / ("config-" + to_hex(fnv1a64(abs.string())) + ".bin");
+    }
+
+    static std::uint32_t load_u32(const char* p)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    /// Perfect-hash bucket and slot of a flat_hash() value.
+    static std::uint32_t phf_bucket(std::uint64_t h, std::uint32_t buckets)
+    {
+        return static_cast<std::uint32_t>((h >> 32) % buckets);
+    }
+
+    static std::uint32_t phf_slot(std::uint64_t h, std::uint32_t displacement, std::uint32_t mask)
+    {
+        std::uint64_t x = h + (std::uint64_t{displacement} + 1) * 0x9e3779b97f4a7c15ull;
+        x ^= x >> 31;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 29;
+        return static_cast<std::uint32_t>(x) & mask;
+    }
+
+    const Entry* find_compiled(std::string_view section, std::string_view key) const
+    {
+        auto h = flat_hash(section, key);
+        auto d = load_u32(phf_ + std::size_t{phf_bucket(h, phf_buckets_)} * 4);
+        auto slot = load_u32(phf_ + (std::size_t{phf_buckets_} + phf_slot(h, d, phf_mask_)) * 4);
+        if (slot == 0) {
+            return nullptr;
+        }
+        const Entry& e = entries_[slot - 1];
+        return flat_equal(e.section, e.key, section, key) ? &e : nullptr;
+    }
+
+    /// Serialize the parsed entries (views into `file_`) with a
+    /// hash-and-displace perfect hash.  Empty if no table was found.
+    [[nodiscard]] std::string compile(const FileStamp& source) const
+    {
+        auto text = file_->view();
+        auto n = static_cast<std::uint32_t>(entries_.size());
+
+        CompiledHeader h{};
+        std::memcpy(h.magic, compiled_magic, sizeof compiled_magic);
+        h.version = compiled_version;
+        h.entry_count = n;
+        h.item_count = static_cast<std::uint32_t>(items_.size());
+        h.section_count = static_cast<std::uint32_t>(sections_.size());
+        h.bucket_count = n / 2 + 1;
+        h.slot_count = 1;
+        while (h.slot_count < n + n / 4 + 1) { // load factor ≤ 0.8
+            h.slot_count *= 2;
+        }
+        h.source = source;
+        h.text_size = text.size();
+
+        // Place the largest buckets first, each at the first displacement
+        // that maps all its keys to free, distinct slots.
+        std::vector<std::uint64_t> hashes(n);
+        std::vector<std::vector<std::uint32_t>> buckets(h.bucket_count);
+        for (std::uint32_t i = 0; i < n; ++i) {
+            hashes[i] = flat_hash(entries_[i].section, entries_[i].key);
+            buckets[phf_bucket(hashes[i], h.bucket_count)].push_back(i);
+        }
+        std::vector<std::uint32_t> order(h.bucket_count);
+        for (std::uint32_t b = 0; b < h.bucket_count; ++b) {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        std::vector<std::uint32_t> displacement(h.bucket_count, 0);
+        std::vector<std::uint32_t> slots(h.slot_count, 0);
+        std::vector<std::uint32_t> taken;
+        for (auto b : order) {
+            const auto& keys = buckets[b];
+            if (keys.empty()) {
+                break;
+            }
+            for (std::uint32_t d = 0;; ++d) {
+                if (d == (1u << 20)) {
+                    return {};
+                }
+                taken.clear();
+                for (auto i : keys) {
+                    auto slot = phf_slot(hashes[i], d, h.slot_count - 1);
+                    if (slots[slot] != 0 ||
+                        std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                        break;
+                    }
+                    taken.push_back(slot);
+                }
+                if (taken.size() == keys.size()) {
+                    for (std::size_t k = 0; k < keys.size(); ++k) {
+                        slots[taken[k]] = keys[k] + 1;
+                    }
+                    displacement[b] = d;
+                    break;
+                }
+            }
+        }
+
+        auto offset = [&](std::string_view v) {
+            return static_cast<std::uint32_t>(v.empty() ? 0 : v.data() - text.data());
+        };
+        auto size = [](std::string_view v) { return static_cast<std::uint32_t>(v.size()); };
+
+        std::string out;
+        out.reserve(sizeof h + n * sizeof(EntryRecord) + items_.size() * sizeof(ItemRecord) +
+                    sections_.size() * sizeof(SectionRecord) +
+                    (displacement.size() + slots.size()) * 4 + text.size());
+        auto put = [&out](const auto& record) {
+            out.append(reinterpret_cast<const char*>(&record), sizeof record);
+        };
+        put(h);
+        for (const auto& e : entries_) {
+            put(EntryRecord{offset(e.section),
+                            size(e.section),
+                            offset(e.key),
+                            size(e.key),
+                            offset(e.value),
+                            size(e.value),
+                            e.first_item,
+                            e.item_count,
+                            e.is_list ? 1u : 0u});
+        }
+        for (auto item : items_) {
+            put(ItemRecord{offset(item), size(item)});
+        }
+        for (const auto& r : sections_) {
+            put(SectionRecord{offset(r.name), size(r.name), r.begin, r.end});
+        }
+        out.append(reinterpret_cast<const char*>(displacement.data()), displacement.size() * 4);
+        out.append(reinterpret_cast<const char*>(slots.data()), slots.size() * 4);
+        out.append(text);
+        return out;
+    }
+
+    /// Point this Config at a compiled image of the file with `source`
+    /// stamp.  Rejects anything stale, foreign, truncated or out of bounds.
+    bool attach(const MappedFile& image, const FileStamp& source)
+    {
+        const char* base = image.data();
+        CompiledHeader h{};
+        if (image.size() < sizeof h) {
+            return false;
+        }
+        std::memcpy(&h, base, sizeof h);
+        if (std::memcmp(h.magic, compiled_magic, sizeof compiled_magic) != 0 ||
+            h.version != compiled_version || h.source != source || h.bucket_count == 0 ||
+            h.slot_count == 0 || (h.slot_count & (h.slot_count - 1)) != 0) {
+            return false;
+        }
+
+        std::uint64_t entries_at = sizeof h;
+        std::uint64_t items_at = entries_at + std::uint64_t{h.entry_count} * sizeof(EntryRecord);
+        std::uint64_t sections_at = items_at + std::uint64_t{h.item_count} * sizeof(ItemRecord);
+        std::uint64_t phf_at = sections_at + std::uint64_t{h.section_count} * sizeof(SectionRecord);
+        std::uint64_t text_at = phf_at + (std::uint64_t{h.bucket_count} + h.slot_count) * 4;
+        if (text_at + h.text_size != image.size()) {
+            return false;
+        }
+
+        const char* text = base + text_at;
+        bool ok = true;
+        auto view = [&](std::uint32_t off, std::uint32_t len) {
+            if (std::uint64_t{off} + len > h.text_size) {
+                ok = false;
+                return std::string_view{};
+            }
+            return std::string_view(text + off, len);
+        };
+
+        entries_.resize(h.entry_count);
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            EntryRecord r;
+            std::memcpy(&r, base + entries_at + i * sizeof r, sizeof r);
+            auto& e = entries_[i];
+            e.section = view(r.section_off, r.section_len);
+            e.key = view(r.key_off, r.key_len);
+            e.value = view(r.value_off, r.value_len);
+            e.first_item = r.first_item;
+            e.item_count = r.item_count;
+            e.is_list = r.is_list != 0;
+            ok = ok && std::uint64_t{r.first_item} + r.item_count <= h.item_count;
+        }
+        items_.resize(h.item_count);
+        for (std::size_t i = 0; i < items_.size(); ++i) {
+            ItemRecord r;
+            std::memcpy(&r, base + items_at + i * sizeof r, sizeof r);
+            items_[i] = view(r.off, r.len);
+        }
+        sections_.resize(h.section_count);
+        for (std::size_t i = 0; i < sections_.size(); ++i) {
+            SectionRecord r;
+            std::memcpy(&r, base + sections_at + i * sizeof r, sizeof r);
+            sections_[i] = {view(r.name_off, r.name_len), r.begin, r.end};
+            ok = ok && r.begin <= r.end && r.end <= h.entry_count;
+        }
+        const char* slots = base + phf_at + std::size_t{h.bucket_count} * 4;
+        for (std::size_t i = 0; i < h.slot_count; ++i) {
+            ok = ok && load_u32(slots + i * 4) <= h.entry_count;
+        }
+        if (!ok) {
+            return false;
+        }
+
+        phf_ = base + phf_at;
+        phf_buckets_ = h.bucket_count;
+        phf_mask_ = h.slot_count - 1;
+        return true;
+    }
+
+    // ── Parser ──────────────────────────────────────────────
+
+    static std::string_view trim(std::string_view s)
     {
         auto a = s.find_first_not_of(" \t\"");
         auto b = s.find_last_not_of(" \t\"");
         if (a == std::string_view::npos) {
             return {};
         }
-        return std::string(s.substr(a, b - a + 1));
+        return s.substr(a, b - a + 1);
     }
 
-    static std::string unquote(std::string_view s)
+    static std::string_view unquote(std::string_view s)
     {
         auto a = s.find_first_not_of(" \t");
         auto b = s.find_last_not_of(" \t");
@@ -187,55 +749,134 @@ class Config
         if (s.size() >= 2 && s.front() == '"' && s.back() == '"') {
             s = s.substr(1, s.size() - 2);
         }
-        return std::string(s);
+        return s;
     }
 
-    static std::vector<std::string> parse_array(std::string_view s)
+    /// Append the items of `[a, b, ...]` to items_; returns their count.
+    std::uint32_t parse_array(std::string_view s)
     {
-        std::vector<std::string> result;
         // Strip [ ]
         auto a = s.find('[');
         auto b = s.rfind(']');
         if (a == std::string_view::npos || b == std::string_view::npos) {
-            return result;
+            return 0;
         }
         s = s.substr(a + 1, b - a - 1);
 
         // Split by comma, unquote each element
-        std::string token;
-        for (char c : s) {
-            if (c == ',') {
-                auto t = unquote(token);
-                if (!t.empty()) {
-                    result.push_back(std::move(t));
-                }
-                token.clear();
-            } else {
-                token += c;
+        std::uint32_t count = 0;
+        for (;;) {
+            auto comma = s.find(',');
+            if (auto t = unquote(s.substr(0, comma)); !t.empty()) {
+                items_.push_back(t);
+                ++count;
             }
+            if (comma == std::string_view::npos) {
+                return count;
+            }
+            s.remove_prefix(comma + 1);
         }
-        auto t = unquote(token);
-        if (!t.empty()) {
-            result.push_back(std::move(t));
-        }
-        return result;
     }
 
-    static fs::path global_config_path()
+    void parse(std::string_view text)
     {
-#ifdef _WIN32
-        const char* appdata = std::getenv("APPDATA");
-        if (appdata) {
-            return fs::path(appdata) / "dev" / "config.toml";
+        // Entries are indexed as they are parsed so a repeated key
+        // overwrites the earlier entry in place (last one wins).
+        slots_.assign(256, 0);
+        std::string_view section;
+
+        while (!text.empty()) {
+            auto nl = text.find('\n');
+            std::string_view line = text.substr(0, nl);
+            text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+
+            // Strip \r (Windows line endings)
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+
+            // Trim leading whitespace; skip comments and empty lines
+            auto start = line.find_first_not_of(" \t");
+            if (start == std::string_view::npos) {
+                continue;
+            }
+            line.remove_prefix(start);
+            if (line[0] == '#') {
+                continue;
+            }
+
+            // Section header: [name]
+            if (line.front() == '[' && line.back() == ']') {
+                section = line.substr(1, line.size() - 2);
+                continue;
+            }
+
+            // Key = value
+            auto eq = line.find('=');
+            if (eq == std::string_view::npos) {
+                continue;
+            }
+
+            Entry e;
+            e.section = section;
+            e.key = trim(line.substr(0, eq));
+            auto val = trim(line.substr(eq + 1));
+
+            // Array: ["a", "b", "c"]
+            if (val.starts_with("[")) {
+                e.is_list = true;
+                e.first_item = static_cast<std::uint32_t>(items_.size());
+                e.item_count = parse_array(val);
+            } else {
+                e.value = unquote(val);
+            }
+
+            auto pos = probe(e.section, e.key);
+            if (slots_[pos] != 0) {
+                Entry& old = entries_[slots_[pos] - 1];
+                e.section = old.section; // stays in its first section
+                e.key = old.key;
+                old = e;
+                continue;
+            }
+            entries_.push_back(e);
+            slots_[pos] = static_cast<std::uint32_t>(entries_.size());
+            if (entries_.size() * 2 > slots_.size()) {
+                rebuild_index();
+            }
         }
-        return {};
-#else
-        const char* home = std::getenv("HOME");
-        if (home) {
-            return fs::path(home) / ".config" / "dev" / "config.toml";
+        group_sections();
+    }
+
+    /// Build the sorted section table.  A section opened more than once
+    /// is made contiguous first (the only case that reorders entries).
+    void group_sections()
+    {
+        auto collect_runs = [this] {
+            std::vector<SectionRange> runs;
+            for (std::uint32_t i = 0; i < entries_.size();) {
+                SectionRange r{entries_[i].section, i, i};
+                while (r.end < entries_.size() && entries_[r.end].section == r.name) {
+                    ++r.end;
+                }
+                runs.push_back(r);
+                i = r.end;
+            }
+            std::sort(runs.begin(), runs.end(), [](const auto& a, const auto& b) {
+                return a.name < b.name;
+            });
+            return runs;
+        };
+        auto same_name = [](const auto& a, const auto& b) { return a.name == b.name; };
+
+        sections_ = collect_runs();
+        if (std::adjacent_find(sections_.begin(), sections_.end(), same_name) != sections_.end()) {
+            std::stable_sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+                return a.section < b.section;
+            });
+            rebuild_index();
+            sections_ = collect_runs();
         }
-        return {};
-#endif
     }
 };
 
@@ -0,0 +1,922 @@
+/**
+ * @file daemon.hpp
+ * @brief Resident dispatcher daemon and its thin client (Linux).
+ *
+ * `dev daemon start` keeps per-directory dispatch state — parsed config,
+ * aliases, plugin dirs and already-resolved plugin paths — in memory and
+ * drops it whenever inotify reports a change to a config file or plugin
+ * dir.  A regular `dev <cmd>` first tries the daemon's Unix socket: it
+ * sends argv, cwd and environment plus its stdin/stdout/stderr via
+ * SCM_RIGHTS, the daemon spawns the plugin on those fds, replies with the
+ * pid (so the client can forward signals) and finally the exit code.
+ * When no daemon answers — or it cannot handle the command — dev falls
+ * back to the normal in-process path.
+ */
+
+#pragma once
+
+#include "dev/config.hpp"
+#include "dev/dispatcher.hpp"
+#include "dev/error.hpp"
+#include "dev/hooks.hpp"
+#include "dev/process.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace dev::daemon {
+
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+inline constexpr bool supported = true;
+#else
+inline constexpr bool supported = false;
+#endif
+
+// ── Location ────────────────────────────────────────────────
+
+/// Socket path: $DEV_DAEMON_SOCKET → $XDG_RUNTIME_DIR/dev/daemon.sock →
+/// /tmp/dev-<uid>/daemon.sock.
+inline fs::path socket_path()
+{
+    if (const char* p = std::getenv("DEV_DAEMON_SOCKET"); p && *p)
+        return p;
+#ifdef __linux__
+    if (const char* run = std::getenv("XDG_RUNTIME_DIR"); run && *run)
+        return fs::path(run) / "dev" / "daemon.sock";
+    return fs::path("/tmp") / ("dev-" + std::to_string(getuid())) / "daemon.sock";
+#else
+    return {};
+#endif
+}
+
+#ifdef __linux__
+
+// ── Wire protocol ───────────────────────────────────────────
+
+namespace detail {
+
+inline constexpr std::uint32_t magic = 0x44455644; // "DEVD"
+
+enum class Kind : std::uint32_t
+{
+    Run = 1,  ///< client → daemon: dispatch argv (fds attached)
+    Ping,     ///< client → daemon: liveness check
+    Stop,     ///< client → daemon: shut down
+    Started,  ///< daemon → client: value = plugin pid
+    Exit,     ///< daemon → client: value = plugin exit code
+    Fallback, ///< daemon → client: run in-process instead
+    Pong,     ///< daemon → client: value = daemon pid
+};
+
+struct Request
+{
+    std::uint32_t magic;
+    Kind kind;
+    std::uint32_t argc;
+    std::uint32_t envc;
+    std::uint64_t payload_size; ///< cwd\0 argv...\0 env...\0
+};
+
+struct Reply
+{
+    Kind kind;
+    std::int32_t value;
+};
+
+inline bool read_full(int fd, void* buf, std::size_t n)
+{
+    auto* p = static_cast<char*>(buf);
+    while (n > 0) {
+        auto r = ::read(fd, p, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+inline bool write_full(int fd, const void* buf, std::size_t n)
+{
+    const auto* p = static_cast<const char*>(buf);
+    while (n > 0) {
+        auto w = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+inline bool reply(int fd, Kind kind, std::int32_t value = 0)
+{
+    Reply r{kind, value};
+    return write_full(fd, &r, sizeof r);
+}
+
+/// Whether `dir` is a real directory (not a symlink) owned by us with mode
+/// 0700, so no other user can have put a socket into it.
+inline bool private_dir(const fs::path& dir)
+{
+    struct stat st{};
+    return ::lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == ::getuid() &&
+           (st.st_mode & 077) == 0;
+}
+
+/// Whether the directory of the default socket path is safe to use.  A
+/// path given via $DEV_DAEMON_SOCKET is the user's choice; only the peer
+/// check in connect_to() applies to it.
+inline bool trusted_socket_dir(const fs::path& path)
+{
+    if (const char* p = std::getenv("DEV_DAEMON_SOCKET"); p && *p)
+        return true;
+    return private_dir(path.parent_path());
+}
+
+/// Connect to the daemon socket.  Returns -1 if nobody is listening, or
+/// if the socket's directory or the listening process is not our own:
+/// the request carries our environment and stdio fds.
+inline int connect_to(const fs::path& path)
+{
+    if (!trusted_socket_dir(path))
+        return -1;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    auto s = path.string();
+    if (s.size() >= sizeof(addr.sun_path))
+        return -1;
+    std::memcpy(addr.sun_path, s.c_str(), s.size() + 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    ucred cred{};
+    socklen_t len = sizeof cred;
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || cred.uid != ::getuid()) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Send a control request (Ping / Stop) and return the daemon's pid.
+inline std::optional<int> control(const fs::path& path, Kind kind)
+{
+    int fd = connect_to(path);
+    if (fd < 0)
+        return std::nullopt;
+    Request req{magic, kind, 0, 0, 0};
+    Reply r{};
+    bool ok = write_full(fd, &req, sizeof req) && read_full(fd, &r, sizeof r) &&
+              r.kind == Kind::Pong;
+    ::close(fd);
+    return ok ? std::optional<int>(r.value) : std::nullopt;
+}
+
+// Client-side signal forwarding to the daemon-spawned plugin.
+inline volatile sig_atomic_t g_child = 0;
+
+inline void forward_signal(int sig)
+{
+    if (g_child > 0)
+        ::kill(static_cast<pid_t>(g_child), sig);
+}
+
+} // namespace detail
+
+#endif // __linux__
+
+// ── Client ──────────────────────────────────────────────────
+
+/// Dispatch argv[1..] through a running daemon.
+///
+/// @return  The plugin's exit code, or std::nullopt if no daemon is
+///          running (or it declined), in which case the caller should
+///          dispatch in-process.  Set DEV_NO_DAEMON=1 to skip the daemon.
+inline std::optional<int> try_dispatch([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+#ifdef __linux__
+    using namespace detail;
+
+    if (const char* off = std::getenv("DEV_NO_DAEMON"); off && *off && *off != '0')
+        return std::nullopt;
+    // Jobserver fds inherited from make (or one to be created) cannot
+    // follow the request into the daemon.
+    if (std::getenv("DEV_JOBS"))
+        return std::nullopt;
+    if (const char* mf = std::getenv("MAKEFLAGS"); mf && std::strstr(mf, "--jobserver-"))
+        return std::nullopt;
+
+    int fd = connect_to(socket_path());
+    if (fd < 0)
+        return std::nullopt;
+
+    // Payload: cwd, argv[1..], environment — all NUL-terminated.
+    std::string payload;
+    std::error_code ec;
+    payload += fs::current_path(ec).string();
+    payload += '\0';
+    for (int i = 1; i < argc; ++i) {
+        payload += argv[i];
+        payload += '\0';
+    }
+    std::uint32_t envc = 0;
+    for (char** e = environ; *e; ++e, ++envc) {
+        payload += *e;
+        payload += '\0';
+    }
+
+    Request req{magic, Kind::Run, static_cast<std::uint32_t>(argc - 1), envc, payload.size()};
+
+    // Header + stdin/stdout/stderr in one sendmsg.
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof fds)] = {};
+    iovec iov{&req, sizeof req};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof fds);
+    std::memcpy(CMSG_DATA(cm), fds, sizeof fds);
+
+    // Everything before "Started" can still fall back safely.
+    std::fflush(nullptr);
+    Reply r{};
+    if (::sendmsg(fd, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof req) ||
+        !write_full(fd, payload.data(), payload.size()) || !read_full(fd, &r, sizeof r) ||
+        r.kind != Kind::Started) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    g_child = r.value;
+    struct sigaction sa{};
+    sa.sa_handler = forward_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    for (int sig : {SIGINT, SIGTERM, SIGHUP, SIGQUIT}) {
+        ::sigaction(sig, &sa, nullptr);
+    }
+
+    bool ok = read_full(fd, &r, sizeof r) && r.kind == Kind::Exit;
+    ::close(fd);
+    if (!ok) {
+        std::println(stderr, "dev: lost connection to daemon");
+        return static_cast<int>(Error::General);
+    }
+    return r.value;
+#else
+    return std::nullopt;
+#endif
+}
+
+#ifdef __linux__
+
+// ── Server ──────────────────────────────────────────────────
+
+namespace detail {
+
+inline int g_wake_fd = -1; // self-pipe: 'C' = SIGCHLD, 'T' = terminate
+
+inline void on_signal(int sig)
+{
+    char c = (sig == SIGCHLD) ? 'C' : 'T';
+    [[maybe_unused]] auto n = ::write(g_wake_fd, &c, 1);
+}
+
+class Server
+{
+public:
+    Server(int listen_fd, const char* argv0)
+        : listen_fd_(listen_fd)
+        , argv0_(argv0)
+    {
+    }
+
+    int run()
+    {
+        int wake[2];
+        if (::pipe2(wake, O_CLOEXEC | O_NONBLOCK) != 0)
+            return static_cast<int>(Error::General);
+        g_wake_fd = wake[1];
+
+        struct sigaction sa{};
+        sa.sa_handler = on_signal;
+        sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+        sigemptyset(&sa.sa_mask);
+        for (int sig : {SIGCHLD, SIGTERM, SIGINT, SIGHUP}) {
+            ::sigaction(sig, &sa, nullptr);
+        }
+
+        inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        std::vector<pollfd> pfds;
+        while (running_) {
+            pfds.clear();
+            pfds.push_back({listen_fd_, POLLIN, 0});
+            pfds.push_back({wake[0], POLLIN, 0});
+            pfds.push_back({inotify_fd_, POLLIN, 0});
+            for (const auto& [client, pid] : clients_) {
+                pfds.push_back({client, POLLIN | POLLRDHUP, 0});
+            }
+            for (const auto& [client, request] : pending_) {
+                pfds.push_back({client, POLLIN, 0});
+            }
+
+            if (::poll(pfds.data(), pfds.size(), poll_timeout()) < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+
+            if (pfds[1].revents & POLLIN)
+                drain_wake(wake[0]);
+            if (pfds[2].revents & POLLIN)
+                drain_inotify();
+            for (std::size_t i = 3; i < pfds.size(); ++i) {
+                if (!pfds[i].revents)
+                    continue;
+                if (pending_.contains(pfds[i].fd))
+                    receive(pfds[i].fd);
+                else
+                    client_hangup(pfds[i].fd);
+            }
+            expire_pending();
+            if (pfds[0].revents & POLLIN)
+                accept_one();
+        }
+
+        ::close(listen_fd_);
+        ::close(wake[0]);
+        ::close(wake[1]);
+        if (inotify_fd_ >= 0)
+            ::close(inotify_fd_);
+        std::error_code ec;
+        fs::remove(socket_path(), ec);
+        return 0;
+    }
+
+private:
+    struct Context
+    {
+        Config cfg;
+        std::vector<fs::path> dirs;
+        std::unordered_map<std::string, std::string> resolved;
+    };
+
+    /// A connection whose request has not fully arrived yet.  Requests are
+    /// read as their bytes come in, so a stalled client holds up no one.
+    struct Pending
+    {
+        Request req{};
+        std::size_t header_got = 0;
+        int fds[3] = {-1, -1, -1};
+        std::string payload;
+        std::size_t payload_got = 0;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    static constexpr std::size_t max_contexts = 256;
+    static constexpr auto request_timeout = std::chrono::seconds(5);
+    static constexpr std::uint32_t dir_events =
+        IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF |
+        IN_MOVE_SELF | IN_MASK_ADD;
+    static constexpr std::uint32_t file_events = dir_events | IN_CLOSE_WRITE | IN_MODIFY;
+
+    int listen_fd_;
+    const char* argv0_;
+    int inotify_fd_ = -1;
+    bool running_ = true;
+    std::unordered_map<std::string, Context> contexts_; // by cwd
+    std::unordered_map<int, bool> watches_;             // wd → is plugin dir
+    std::unordered_map<pid_t, int> jobs_;               // plugin pid → client fd
+    std::unordered_map<int, pid_t> clients_;            // client fd → plugin pid
+    std::unordered_map<int, Pending> pending_;          // client fd → partial request
+
+    // ── Invalidation ────────────────────────────────────────
+
+    void watch(const fs::path& dir, bool plugin_dir)
+    {
+        if (inotify_fd_ < 0)
+            return;
+        int wd = ::inotify_add_watch(
+            inotify_fd_, dir.c_str(), plugin_dir ? dir_events : file_events);
+        if (wd >= 0)
+            watches_[wd] = watches_[wd] || plugin_dir;
+    }
+
+    void drain_inotify()
+    {
+        alignas(inotify_event) char buf[4096];
+        bool dirty = false;
+        for (;;) {
+            auto n = ::read(inotify_fd_, buf, sizeof buf);
+            if (n <= 0)
+                break;
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+
+                std::string_view name = ev->len ? std::string_view(ev->name) : "";
+                auto it = watches_.find(ev->wd);
+                bool plugin_dir = it != watches_.end() && it->second;
+                // Context dirs (cwd, exe dir, global config dir) change all
+                // the time; only entries dev actually reads matter there.
+                if ((ev->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) ||
+                    plugin_dir || name == "dev.toml" || name == "plugins" ||
+                    name == "plugins.toml" || name == "config.toml") {
+                    dirty = true;
+                }
+                if (ev->mask & IN_IGNORED)
+                    watches_.erase(ev->wd);
+            }
+        }
+        if (dirty)
+            contexts_.clear();
+    }
+
+    // ── Children ────────────────────────────────────────────
+
+    void drain_wake(int fd)
+    {
+        char buf[64];
+        bool reap = false;
+        for (;;) {
+            auto n = ::read(fd, buf, sizeof buf);
+            if (n <= 0)
+                break;
+            for (ssize_t i = 0; i < n; ++i) {
+                if (buf[i] == 'T')
+                    running_ = false;
+                else
+                    reap = true;
+            }
+        }
+        if (!reap)
+            return;
+
+        int status = 0;
+        pid_t pid;
+        while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+            auto it = jobs_.find(pid);
+            if (it == jobs_.end())
+                continue;
+            int code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+            reply(it->second, Kind::Exit, code);
+            clients_.erase(it->second);
+            ::close(it->second);
+            jobs_.erase(it);
+        }
+    }
+
+    /// Client went away before its plugin finished: hang the plugin up,
+    /// as a closing terminal would.
+    void client_hangup(int fd)
+    {
+        char buf[64];
+        auto n = ::recv(fd, buf, sizeof buf, MSG_DONTWAIT);
+        if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EINTR)))
+            return; // stray data, not a hangup
+        auto it = clients_.find(fd);
+        if (it == clients_.end())
+            return;
+        ::kill(it->second, SIGHUP);
+        jobs_.erase(it->second);
+        clients_.erase(it);
+        ::close(fd);
+    }
+
+    // ── Requests ────────────────────────────────────────────
+
+    void accept_one()
+    {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0)
+            return;
+
+        // Only serve our own user.
+        ucred cred{};
+        socklen_t len = sizeof cred;
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || cred.uid != getuid()) {
+            ::close(fd);
+            return;
+        }
+        pending_[fd].deadline = std::chrono::steady_clock::now() + request_timeout;
+        receive(fd); // usually the whole request is already there
+    }
+
+    /// Milliseconds until the oldest pending request expires (-1 = none).
+    [[nodiscard]] int poll_timeout() const
+    {
+        if (pending_.empty())
+            return -1;
+        auto first = std::min_element(pending_.begin(), pending_.end(), [](auto& a, auto& b) {
+                         return a.second.deadline < b.second.deadline;
+                     })->second.deadline;
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(
+            first - std::chrono::steady_clock::now());
+        return static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+    }
+
+    void drop_pending(int fd)
+    {
+        auto it = pending_.find(fd);
+        if (it == pending_.end())
+            return;
+        for (int f : it->second.fds) {
+            if (f >= 0)
+                ::close(f);
+        }
+        pending_.erase(it);
+        ::close(fd);
+    }
+
+    void expire_pending()
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<int> expired;
+        for (const auto& [fd, p] : pending_) {
+            if (p.deadline <= now)
+                expired.push_back(fd);
+        }
+        for (int fd : expired) {
+            drop_pending(fd);
+        }
+    }
+
+    /// Read whatever has arrived of `fd`'s request without blocking; handle
+    /// it once complete.
+    void receive(int fd)
+    {
+        auto& p = pending_[fd];
+        while (p.header_got < sizeof p.req) {
+            iovec iov{reinterpret_cast<char*>(&p.req) + p.header_got, sizeof p.req - p.header_got};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof p.fds)] = {};
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof control;
+            auto n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+            if (n < 0 && (errno == EAGAIN || errno == EINTR))
+                return;
+            for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+                if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS)
+                    continue;
+                int got[3] = {-1, -1, -1};
+                auto count = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                std::memcpy(got, CMSG_DATA(cm), std::min<std::size_t>(count, 3) * sizeof(int));
+                if (count == 3 && p.fds[0] < 0) {
+                    std::memcpy(p.fds, got, sizeof got);
+                } else {
+                    for (std::size_t i = 0; i < std::min<std::size_t>(count, 3); ++i)
+                        ::close(got[i]);
+                }
+            }
+            if (n <= 0) {
+                drop_pending(fd);
+                return;
+            }
+            p.header_got += static_cast<std::size_t>(n);
+            if (p.header_got < sizeof p.req)
+                continue;
+            if (p.req.magic != magic) {
+                drop_pending(fd);
+                return;
+            }
+            if (p.req.kind == Kind::Run) {
+                if (p.req.payload_size > (std::uint64_t{1} << 24)) {
+                    reply(fd, Kind::Fallback);
+                    drop_pending(fd);
+                    return;
+                }
+                p.payload.resize(static_cast<std::size_t>(p.req.payload_size));
+            }
+        }
+        while (p.payload_got < p.payload.size()) {
+            auto n = ::recv(
+                fd, p.payload.data() + p.payload_got, p.payload.size() - p.payload_got, MSG_DONTWAIT);
+            if (n < 0 && (errno == EAGAIN || errno == EINTR))
+                return;
+            if (n <= 0) {
+                drop_pending(fd);
+                return;
+            }
+            p.payload_got += static_cast<std::size_t>(n);
+        }
+
+        Pending request = std::move(p);
+        pending_.erase(fd);
+        if (!handle(fd, request))
+            ::close(fd);
+    }
+
+    /// Returns true if `fd` is now owned by a running job.  Replies are a
+    /// few bytes into an empty socket buffer, so the non-blocking sends
+    /// complete at once.
+    bool handle(int fd, Pending& request)
+    {
+        auto close_fds = [&] {
+            for (int& f : request.fds) {
+                if (f >= 0)
+                    ::close(f);
+                f = -1;
+            }
+        };
+
+        switch (request.req.kind) {
+            case Kind::Ping:
+                reply(fd, Kind::Pong, ::getpid());
+                close_fds();
+                return false;
+            case Kind::Stop:
+                reply(fd, Kind::Pong, ::getpid());
+                running_ = false;
+                close_fds();
+                return false;
+            case Kind::Run:
+                break;
+            default:
+                close_fds();
+                return false;
+        }
+
+        pid_t pid = spawn_plugin(request.req, request.fds, request.payload);
+        close_fds();
+        if (pid <= 0) {
+            reply(fd, Kind::Fallback);
+            return false;
+        }
+        // A failed reply means the client already left; client_hangup()
+        // cleans up on the next poll.
+        jobs_[pid] = fd;
+        clients_[fd] = pid;
+        reply(fd, Kind::Started, pid);
+        return true;
+    }
+
+    /// Resolve and spawn.  Returns the plugin pid, or -1 to fall back.
+    pid_t spawn_plugin(const Request& req, const int (&fds)[3], const std::string& payload)
+    {
+        if (fds[0] < 0 || fds[1] < 0 || fds[2] < 0 || req.argc == 0)
+            return -1;
+
+        std::vector<std::string_view> parts;
+        for (std::size_t pos = 0; pos < payload.size();) {
+            auto end = payload.find('\0', pos);
+            if (end == std::string::npos)
+                return -1;
+            parts.emplace_back(payload.data() + pos, end - pos);
+            pos = end + 1;
+        }
+        if (parts.size() != 1 + std::size_t{req.argc} + req.envc)
+            return -1;
+
+        // The daemon never changes its own directory: everything is
+        // resolved against the client's cwd, which the plugin starts in.
+        std::string cwd(parts[0]);
+        if (cwd.empty() || cwd.front() != '/')
+            return -1;
+
+        Context& ctx = context(cwd);
+
+        std::string command(parts[1]);
+        if (auto target = ctx.cfg.get("alias", command); !target.empty())
+            command = std::move(target);
+        if (is_builtin(command))
+            return -1;
+        // Resource accounting and a jobserver pipe need the client to be
+        // the plugin's parent.
+        if (ctx.cfg.get("dispatch", "time") == "json" || ctx.cfg.get_bool("dispatch", "time") ||
+            !ctx.cfg.get("jobserver", "jobs").empty())
+            return -1;
+        // Hooks run around the plugin in the client; exec-through must
+        // replace the client itself.
+        if (!load_hooks(ctx.cfg, command).empty() || ctx.cfg.get_bool("dispatch", "exec"))
+            return -1;
+
+        auto it = ctx.resolved.find(command);
+        if (it == ctx.resolved.end()) {
+            auto plugin = resolve_plugin(command, ctx.dirs);
+            if (plugin.empty())
+                return -1; // in-process path prints the proper error
+            it = ctx.resolved.emplace(command, plugin.string()).first;
+        }
+        // Shared plugins run in the client's own process: cheaper than
+        // any spawn from here.
+        if (is_shared_plugin(it->second))
+            return -1;
+
+        // parts are views into `payload`, which is NUL-separated, so
+        // their data() pointers are valid C strings.
+        std::vector<const char*> argv;
+        argv.push_back(it->second.c_str());
+        for (std::size_t i = 2; i < 1 + std::size_t{req.argc}; ++i)
+            argv.push_back(parts[i].data());
+        argv.push_back(nullptr);
+
+        // The client's spawn backend, chosen as main() would: its
+        // DEV_SPAWN_BACKEND, then [process] backend.  Unknown names fall
+        // back so the client reports them.
+        std::string_view backend_name = ctx.cfg.value("process", "backend").value_or("");
+        std::vector<char*> envp;
+        for (std::size_t i = 1 + std::size_t{req.argc}; i < parts.size(); ++i) {
+            if (parts[i].starts_with("DEV_SPAWN_BACKEND="))
+                backend_name = parts[i].substr(sizeof "DEV_SPAWN_BACKEND=" - 1);
+            envp.push_back(const_cast<char*>(parts[i].data()));
+        }
+        envp.push_back(nullptr);
+
+        SpawnBackend backend = g_spawn_backend;
+        if (!backend_name.empty()) {
+            auto parsed = parse_spawn_backend(backend_name);
+            if (!parsed)
+                return -1;
+            backend = *parsed;
+        }
+
+        SpawnOptions opts;
+        opts.in = fds[0];
+        opts.out = fds[1];
+        opts.err = fds[2];
+        opts.cwd = cwd.c_str();
+        opts.envp = envp.data();
+        return start(it->second.c_str(), argv.data(), opts, backend);
+    }
+
+    Context& context(const std::string& cwd)
+    {
+        if (auto it = contexts_.find(cwd); it != contexts_.end())
+            return it->second;
+        if (contexts_.size() >= max_contexts)
+            contexts_.clear();
+
+        Context ctx;
+        ctx.cfg = Config::find(argv0_, cwd);
+        ctx.dirs = find_all_plugin_dirs(argv0_, ctx.cfg, cwd);
+
+        watch(cwd, false);
+        watch(exe_dir(argv0_), false);
+        if (auto global = Config::global_config_path(); !global.empty())
+            watch(global.parent_path(), false);
+        for (const auto& d : ctx.dirs)
+            watch(d, true);
+
+        return contexts_.emplace(cwd, std::move(ctx)).first->second;
+    }
+};
+
+} // namespace detail
+
+#endif // __linux__
+
+// ── Control ─────────────────────────────────────────────────
+
+/// `dev daemon status` — 0 if a daemon answers.
+inline int status()
+{
+#ifdef __linux__
+    if (auto pid = detail::control(socket_path(), detail::Kind::Ping)) {
+        std::println("dev daemon: running (pid {}) on {}", *pid, socket_path().string());
+        return 0;
+    }
+#endif
+    std::println("dev daemon: not running");
+    return static_cast<int>(Error::General);
+}
+
+/// `dev daemon stop`.
+inline int stop()
+{
+#ifdef __linux__
+    if (auto pid = detail::control(socket_path(), detail::Kind::Stop)) {
+        std::println("dev daemon: stopped (pid {})", *pid);
+        return 0;
+    }
+#endif
+    std::println("dev daemon: not running");
+    return static_cast<int>(Error::General);
+}
+
+/// `dev daemon start` (background) / `dev daemon run` (foreground).
+inline int start([[maybe_unused]] const char* argv0, [[maybe_unused]] bool foreground)
+{
+#ifdef __linux__
+    auto path = socket_path();
+    if (auto pid = detail::control(path, detail::Kind::Ping)) {
+        std::println("dev daemon: already running (pid {})", *pid);
+        return 0;
+    }
+
+    std::error_code ec;
+    auto dir = path.parent_path();
+    fs::create_directories(dir, ec);
+    // Tighten a dir we own (created above with the umask's mode) but never
+    // follow a symlink or adopt someone else's dir: clients would refuse it.
+    if (struct stat st{}; ::lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+                          st.st_uid == ::getuid()) {
+        ::chmod(dir.c_str(), 0700);
+    }
+    if (!detail::trusted_socket_dir(path)) {
+        std::println(stderr,
+                     "dev daemon: {} is not a private directory (must be ours, mode 0700)",
+                     dir.string());
+        return static_cast<int>(Error::General);
+    }
+    fs::remove(path, ec); // stale socket from a dead daemon
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    auto s = path.string();
+    if (s.size() >= sizeof(addr.sun_path)) {
+        std::println(stderr, "dev daemon: socket path too long: {}", s);
+        return static_cast<int>(Error::General);
+    }
+    std::memcpy(addr.sun_path, s.c_str(), s.size() + 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    auto old_mask = ::umask(0077);
+    bool bound = fd >= 0 && ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0 &&
+                 ::listen(fd, 64) == 0;
+    ::umask(old_mask);
+    if (!bound) {
+        std::println(stderr, "dev daemon: cannot listen on {}: {}", s, std::strerror(errno));
+        if (fd >= 0)
+            ::close(fd);
+        return static_cast<int>(Error::General);
+    }
+
+    if (!foreground) {
+        std::fflush(nullptr);
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            ::close(fd);
+            return static_cast<int>(Error::General);
+        }
+        if (pid > 0) {
+            ::close(fd);
+            std::println("dev daemon: started (pid {}) on {}", pid, s);
+            return 0;
+        }
+        ::setsid();
+        int null = ::open("/dev/null", O_RDWR);
+        if (null >= 0) {
+            ::dup2(null, STDIN_FILENO);
+            ::dup2(null, STDOUT_FILENO);
+            ::dup2(null, STDERR_FILENO);
+            if (null > STDERR_FILENO)
+                ::close(null);
+        }
+    } else {
+        std::println("dev daemon: listening on {}", s);
+    }
+
+    // Requests carry their own cwd; do not pin (or keep alive) the one we
+    // were started in.  exe_path() caches before argv0 loses its meaning.
+    exe_path(argv0);
+    [[maybe_unused]] int rc = ::chdir("/");
+    return detail::Server(fd, argv0).run();
+#else
+    std::println(stderr, "dev daemon: not supported on this platform");
+    return static_cast<int>(Error::General);
+#endif
+}
+
+} // namespace dev::daemon
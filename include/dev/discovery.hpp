@@ -0,0 +1,244 @@
+/**
+ * @file discovery.hpp
+ * @brief Plugin directory scanning: raw directory reads, no per-file stat.
+ *
+ * Linux reads each directory with getdents64(2) into a 32 KiB buffer and
+ * trusts d_type, so a regular file costs no stat(); only symlinks (and
+ * filesystems that report DT_UNKNOWN) are resolved with one fstatat()
+ * relative to the open directory.  Other POSIX systems use readdir(3)
+ * with the same d_type shortcut; Windows' directory iterator already
+ * carries the file type.
+ *
+ * Several dirs are scanned concurrently — on a network mount the scan is
+ * latency, not CPU — and each scan yields its sorted file list, so the
+ * caller can merge names and resolve plugins without touching the
+ * filesystem again.
+ */
+
+#pragma once
+
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// One scanned plugin dir.
+struct DirScan
+{
+    fs::path dir;
+    std::vector<std::string> files; ///< regular files (symlinks followed), sorted
+    std::vector<std::string> names; ///< plugin names: file stems, sorted, unique
+    std::chrono::microseconds elapsed{};
+    bool ok = false; ///< the directory could be read
+};
+
+/// Command name for a plugin file: the name without its last extension
+/// (same rule as fs::path::stem(), so `.hidden` stays whole).
+constexpr std::string_view plugin_stem(std::string_view file)
+{
+    auto dot = file.rfind('.');
+    if (dot == std::string_view::npos || dot == 0) {
+        return file;
+    }
+    return file.substr(0, dot);
+}
+
+namespace detail {
+
+#ifndef _WIN32
+/// Whether `name` in the open directory `dirfd` is (or links to) a
+/// regular file, given the directory entry's d_type.
+inline bool is_regular_entry(int dirfd, const char* name, unsigned char type)
+{
+    if (type == DT_REG) {
+        return true;
+    }
+    if (type != DT_LNK && type != DT_UNKNOWN) {
+        return false;
+    }
+    struct stat st{};
+    return ::fstatat(dirfd, name, &st, 0) == 0 && S_ISREG(st.st_mode);
+}
+
+inline bool is_dot_or_dotdot(const char* name)
+{
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+#endif
+
+/// Append the regular files of `dir` to `files`; false if unreadable.
+inline bool read_dir(const fs::path& dir, std::vector<std::string>& files)
+{
+#if defined(__linux__)
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // linux_dirent64: u64 ino, s64 off, u16 reclen, u8 type, char name[].
+    constexpr std::size_t reclen_at = 16;
+    constexpr std::size_t type_at = 18;
+    constexpr std::size_t name_at = 19;
+    alignas(8) char buf[32 * 1024];
+    for (;;) {
+        long n = ::syscall(SYS_getdents64, fd, buf, sizeof buf);
+        if (n <= 0) {
+            break;
+        }
+        for (long pos = 0; pos < n;) {
+            const char* rec = buf + pos;
+            std::uint16_t reclen;
+            std::memcpy(&reclen, rec + reclen_at, sizeof reclen);
+            const char* name = rec + name_at;
+            auto type = static_cast<unsigned char>(rec[type_at]);
+            if (!is_dot_or_dotdot(name) && is_regular_entry(fd, name, type)) {
+                files.emplace_back(name);
+            }
+            pos += reclen;
+        }
+    }
+    ::close(fd);
+    return true;
+#elif !defined(_WIN32)
+    DIR* d = ::opendir(dir.c_str());
+    if (!d) {
+        return false;
+    }
+    while (const dirent* e = ::readdir(d)) {
+        if (!is_dot_or_dotdot(e->d_name) && is_regular_entry(::dirfd(d), e->d_name, e->d_type)) {
+            files.emplace_back(e->d_name);
+        }
+    }
+    ::closedir(d);
+    return true;
+#else
+    std::error_code ec;
+    fs::directory_iterator it(dir, ec);
+    if (ec) {
+        return false;
+    }
+    for (; it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        if (it->is_regular_file(ec)) {
+            files.push_back(it->path().filename().string());
+        }
+    }
+    return true;
+#endif
+}
+
+} // namespace detail
+
+/// Scan one plugin dir.  A missing dir yields an empty scan.
+inline DirScan scan_plugin_dir(const fs::path& dir)
+{
+    trace::Span span("scan", trace::enabled() ? dir.string() : std::string{});
+    auto start = std::chrono::steady_clock::now();
+
+    DirScan scan;
+    scan.dir = dir;
+    scan.ok = detail::read_dir(dir, scan.files);
+    std::sort(scan.files.begin(), scan.files.end());
+
+    scan.names.reserve(scan.files.size());
+    for (const auto& f : scan.files) {
+        scan.names.emplace_back(plugin_stem(f));
+    }
+    std::sort(scan.names.begin(), scan.names.end());
+    // `tool` and `tool.so` side by side are one command.
+    scan.names.erase(std::unique(scan.names.begin(), scan.names.end()), scan.names.end());
+
+    scan.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    return scan;
+}
+
+/// Scan several plugin dirs concurrently: the caller's thread and up to
+/// `max_helpers` more take dirs off a shared counter, so a slow mount
+/// delays only its own scan.  Results are in `dirs` order.
+inline std::vector<DirScan> scan_plugin_dirs(const std::vector<fs::path>& dirs,
+                                             std::size_t max_helpers = 3)
+{
+    std::vector<DirScan> scans(dirs.size());
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < dirs.size();) {
+            scans[i] = scan_plugin_dir(dirs[i]);
+        }
+    };
+
+    std::size_t helpers = dirs.empty() ? 0 : std::min(dirs.size() - 1, max_helpers);
+    {
+        std::vector<std::jthread> workers; // joined at the end of this scope
+        workers.reserve(helpers);
+        for (std::size_t i = 0; i < helpers; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+    }
+    return scans;
+}
+
+/// Plugin names across scans: the per-dir sorted runs merged pairwise,
+/// then deduplicated — one flat sorted vector.
+inline std::vector<std::string> merge_plugin_names(const std::vector<DirScan>& scans)
+{
+    std::vector<std::string> names;
+    std::vector<std::size_t> runs{0};
+    std::size_t total = 0;
+    for (const auto& s : scans) {
+        total += s.names.size();
+    }
+    names.reserve(total);
+    for (const auto& s : scans) {
+        names.insert(names.end(), s.names.begin(), s.names.end());
+        runs.push_back(names.size());
+    }
+
+    // Bottom-up merge sort over the runs: O(n log dirs).
+    while (runs.size() > 2) {
+        std::vector<std::size_t> merged{0};
+        for (std::size_t r = 0; r + 1 < runs.size(); r += 2) {
+            auto first = names.begin() + static_cast<std::ptrdiff_t>(runs[r]);
+            if (r + 2 < runs.size()) {
+                std::inplace_merge(first,
+                                   names.begin() + static_cast<std::ptrdiff_t>(runs[r + 1]),
+                                   names.begin() + static_cast<std::ptrdiff_t>(runs[r + 2]));
+                merged.push_back(runs[r + 2]);
+            } else {
+                merged.push_back(runs[r + 1]);
+            }
+        }
+        runs = std::move(merged);
+    }
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+} // namespace dev
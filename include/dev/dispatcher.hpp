@@ -6,16 +6,22 @@
 #pragma once
 
 #include "dev/config.hpp"
+#include "dev/discovery.hpp"
 #include "dev/error.hpp"
+#include "dev/hooks.hpp"
+#include "dev/loader.hpp"
 #include "dev/process.hpp"
+#include "dev/self.hpp"
 #include "dev/style.hpp"
+#include "dev/trace.hpp"
 
 #include <algorithm>
+#include <array>
 #include <filesystem>
 #include <print>
-#include <set>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <vector>
 
 namespace dev {
@@ -23,21 +29,23 @@ namespace dev {
 namespace fs = std::filesystem;
 
 /// Collect all plugin search directories (exe-relative + cwd + config).
-inline std::vector<fs::path> find_all_plugin_dirs(const char* argv0, const Config& cfg = {})
+/// Relative paths are taken against `cwd` (default: the process's).
+inline std::vector<fs::path> find_all_plugin_dirs(const char* argv0,
+                                                  const Config& cfg = {},
+                                                  const fs::path& cwd = {})
 {
-
+    const fs::path base = cwd.empty() ? fs::current_path() : cwd;
     std::vector<fs::path> dirs;
 
     // 1. Exe-relative
-    auto exe = fs::weakly_canonical(fs::path(argv0));
-    auto exe_dir = exe.parent_path() / "plugins";
-    if (fs::is_directory(exe_dir)) {
-        dirs.push_back(exe_dir);
+    auto exe_plugins = exe_dir(argv0) / "plugins";
+    if (fs::is_directory(exe_plugins)) {
+        dirs.push_back(exe_plugins);
     }
 
     // 2. Cwd-relative
-    auto cwd_dir = fs::current_path() / "plugins";
-    if (fs::is_directory(cwd_dir) && cwd_dir != exe_dir) {
+    auto cwd_dir = base / "plugins";
+    if (fs::is_directory(cwd_dir) && cwd_dir != exe_plugins) {
         dirs.push_back(cwd_dir);
     }
 
@@ -53,6 +61,9 @@ inline std::vector<fs::path> find_all_plugin_dirs(const char* argv0, const Confi
             }
         }
 #endif
+        if (!cwd.empty() && dir.is_relative()) {
+            dir = base / dir;
+        }
         if (fs::is_directory(dir)) {
             dirs.push_back(dir);
         }
@@ -60,7 +71,7 @@ inline std::vector<fs::path> find_all_plugin_dirs(const char* argv0, const Confi
 
     // Fallback: if nothing found, include cwd/plugins anyway
     if (dirs.empty()) {
-        dirs.push_back(fs::current_path() / "plugins");
+        dirs.push_back(base / "plugins");
     }
 
     return dirs;
@@ -73,16 +84,28 @@ inline fs::path find_plugins_dir(const char* argv0)
     return dirs.empty() ? (fs::current_path() / "plugins") : dirs.front();
 }
 
-/// Resolve a command name to its plugin executable path.
-/// Searches a single directory.
+/// Resolve a command name to its plugin path (shared library or
+/// executable).  Searches a single directory.
 inline fs::path resolve_plugin(std::string_view command, const fs::path& dir)
 {
+    // One path object for both probes: appending and stripping the
+    // extension in place costs fewer allocations than building two.
+    std::string file(command);
+    file += shared_plugin_ext;
+    fs::path path = dir / file;
+
+    // One stat() each: is_regular_file is false for missing paths too.
+    // A shared-library plugin runs in-process, so it wins over an executable.
+    std::error_code ec;
+    if (fs::is_regular_file(path, ec)) {
+        return path;
+    }
 #ifdef _WIN32
-    fs::path path = dir / (std::string(command) + ".exe");
+    path.replace_extension(".exe");
 #else
-    fs::path path = dir / std::string(command);
+    path.replace_extension();
 #endif
-    if (fs::exists(path) && fs::is_regular_file(path)) {
+    if (fs::is_regular_file(path, ec)) {
         return path;
     }
     return {};
@@ -100,56 +123,135 @@ inline fs::path resolve_plugin(std::string_view command, const std::vector<fs::p
     return {};
 }
 
-/// Return a sorted, deduplicated list of plugin names from one dir.
-inline std::vector<std::string> list_plugins(const fs::path& dir)
+/// Resolve a command against completed scans (see dev/discovery.hpp):
+/// the same rules as resolve_plugin(), answered without a syscall.
+inline fs::path resolve_plugin(std::string_view command, const std::vector<DirScan>& scans)
 {
-    std::vector<std::string> names;
-    if (!fs::is_directory(dir)) {
-        return names;
-    }
-
-    for (const auto& entry : fs::directory_iterator(dir)) {
-        if (!entry.is_regular_file()) {
-            continue;
+    std::string shared(command);
+    shared += shared_plugin_ext;
+#ifdef _WIN32
+    std::string exe = std::string(command) + ".exe";
+#else
+    std::string_view exe = command;
+#endif
+    auto has = [](const DirScan& s, std::string_view file) {
+        return std::binary_search(s.files.begin(), s.files.end(), file);
+    };
+    for (const auto& s : scans) {
+        if (has(s, shared)) {
+            return s.dir / shared;
+        }
+        if (has(s, exe)) {
+            return s.dir / exe;
         }
-        names.push_back(entry.path().stem().string());
     }
-    std::sort(names.begin(), names.end());
-    return names;
+    return {};
+}
+
+/// Return a sorted, deduplicated list of plugin names from one dir.
+inline std::vector<std::string> list_plugins(const fs::path& dir)
+{
+    return scan_plugin_dir(dir).names;
 }
 
-/// Return a sorted, deduplicated list from multiple directories.
+/// Return a sorted, deduplicated list from multiple directories, scanned
+/// concurrently.
 inline std::vector<std::string> list_plugins(const std::vector<fs::path>& dirs)
 {
-    std::set<std::string> seen;
-    for (const auto& dir : dirs) {
-        for (const auto& name : list_plugins(dir)) {
-            seen.insert(name);
-        }
+    return merge_plugin_names(scan_plugin_dirs(dirs));
+}
+
+/// Built-in command names (flags like --help aside).
+inline constexpr std::array<std::string_view, 6> builtin_commands = {
+    "list", "help", "daemon", "par", "pipe", "task"};
+
+/// Commands handled by dev itself.  They shadow plugins of the same name.
+inline bool is_builtin(std::string_view command)
+{
+    return std::find(builtin_commands.begin(), builtin_commands.end(), command) !=
+               builtin_commands.end() ||
+           command == "--help" || command == "-h" || command == "--version" || command == "-v";
+}
+
+/// The default "command not found" report.
+inline void report_not_found(std::string_view command, const std::vector<fs::path>& dirs)
+{
+    std::println(stderr, "dev: command '{}' not found", command);
+    std::println(stderr, "  searched in:");
+    for (const auto& d : dirs) {
+        std::println(stderr, "    {}", d.string());
     }
-    return {seen.begin(), seen.end()};
 }
 
+/// Per-invocation dispatch behaviour.
+struct DispatchOptions
+{
+    /// Replace the dev process with the plugin instead of fork + wait.
+    /// Features that need a parent process after the plugin starts
+    /// (--trace, --time) force the fork + wait path regardless of this flag.
+    bool exec = false;
+
+    /// If set, receives the plugin's resource usage after it exits.
+    ResourceUsage* usage = nullptr;
+
+    /// Run shared-library plugins in a forked child instead of in-process,
+    /// so a crash is reported as an exit code.  POSIX only.
+    bool isolate = false;
+
+    /// Hooks to run around the plugin (see dev/hooks.hpp).  Post hooks
+    /// need dev alive afterwards, so they also rule out exec.
+    const Hooks* hooks = nullptr;
+
+    /// Called with dispatch()'s arguments when no plugin dir provides
+    /// argv[1], instead of report_not_found(); its result is returned.
+    int (*not_found)(int argc, char* argv[]) = nullptr;
+};
+
 /// Dispatch a command to its plugin, searching across all dirs.
-inline int dispatch(int argc, char* argv[], const std::vector<fs::path>& dirs)
+inline int dispatch(int argc,
+                    char* argv[],
+                    const std::vector<fs::path>& dirs,
+                    const DispatchOptions& opts = {})
 {
     if (argc < 2) {
         return static_cast<int>(Error::InvalidUsage);
     }
 
     std::string_view command = argv[1];
-    fs::path plugin = resolve_plugin(command, dirs);
+    fs::path plugin;
+    {
+        trace::Span span("resolve", command);
+        plugin = resolve_plugin(command, dirs);
+    }
 
     if (plugin.empty()) {
-        std::println(stderr, "dev: command '{}' not found", command);
-        std::println(stderr, "  searched in:");
-        for (const auto& d : dirs) {
-            std::println(stderr, "    {}", d.string());
+        if (opts.not_found) {
+            return opts.not_found(argc, argv);
         }
+        report_not_found(command, dirs);
         return static_cast<int>(Error::CommandNotFound);
     }
 
-    return spawn(plugin, argc, argv);
+    const Hooks no_hooks;
+    const Hooks& hooks = opts.hooks ? *opts.hooks : no_hooks;
+    if (int rc = run_pre_hooks(hooks, command); rc != 0) {
+        return rc;
+    }
+
+    int rc = 0;
+    if (is_shared_plugin(plugin)) {
+        rc = run_shared_plugin(plugin, argc, argv, 2, opts.isolate, opts.usage);
+    } else if (opts.exec && !trace::enabled() && !opts.usage && !hooks.has_post()) {
+        // Tracing, accounting and post hooks need dev alive to wait for the plugin.
+        rc = exec(plugin, argc, argv);
+        std::println(stderr, "dev: cannot execute '{}'", plugin.string());
+        return rc;
+    } else {
+        rc = spawn(plugin, argc, argv, 2, opts.usage);
+    }
+
+    run_post_hooks(hooks, command, rc);
+    return rc;
 }
 
 /// Legacy overload — single implicit dir.
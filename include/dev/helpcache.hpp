@@ -0,0 +1,406 @@
+/**
+ * @file helpcache.hpp
+ * @brief Cached `<plugin> --help` output, keyed on the plugin's identity.
+ *
+ * Heavy plugins (JVM or Python tools) take up to a second just to print
+ * their help.  The output of a run is stored in the cache dir, one file
+ * per command, stamped with the plugin's path, inode, size and mtime; a
+ * later `dev help <cmd>` is one stat(), one read() of the entry and one
+ * write() to the terminal.  An entry whose stamp no longer matches is
+ * still served, and the caller refreshes it in the background.
+ *
+ * Entry layout (native endianness): Header, then the plugin path, the
+ * command name, stdout and stderr bytes.
+ *
+ * Capturing needs pipes and poll(); on Windows nothing is captured and
+ * callers run the plugin directly.
+ */
+
+#pragma once
+
+#include "dev/cache.hpp"
+#include "dev/loader.hpp"
+#include "dev/mmap.hpp"
+#include "dev/parallel.hpp"
+#include "dev/process.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// Output of one `--help` run.
+struct HelpText
+{
+    std::string out;
+    std::string err;
+    int exit_code = 0;
+    bool timed_out = false; ///< killed at the deadline; the output is partial
+};
+
+/// A help run to capture: `exe args...`.
+struct HelpJob
+{
+    fs::path exe;
+    std::vector<std::string> args; ///< e.g. {"--help"}, or {"<name>", "--help"} for a built-in
+};
+
+// ── Capture ─────────────────────────────────────────────────
+
+#ifndef _WIN32
+namespace detail {
+
+struct HelpChild
+{
+    std::size_t index = 0;
+    process_id pid = -1;
+    int fd[2] = {-1, -1}; ///< read ends: [0] stdout, [1] stderr
+    std::chrono::steady_clock::time_point deadline;
+};
+
+inline bool start_help(const HelpJob& job, int null_in, HelpChild& c)
+{
+    int out[2];
+    int err[2];
+    if (!make_pipe(out)) {
+        return false;
+    }
+    if (!make_pipe(err)) {
+        ::close(out[0]);
+        ::close(out[1]);
+        return false;
+    }
+
+    std::string exe = job.exe.string();
+    std::vector<const char*> argv{exe.c_str()};
+    for (const auto& a : job.args) {
+        argv.push_back(a.c_str());
+    }
+    argv.push_back(nullptr);
+
+    SpawnOptions so;
+    so.in = null_in; // help that waits for input must not hang dev
+    so.out = out[1];
+    so.err = err[1];
+    c.pid = start_plugin(job.exe, argv.data(), so);
+    ::close(out[1]);
+    ::close(err[1]);
+    c.fd[0] = out[0];
+    c.fd[1] = err[0];
+    if (c.pid == -1) {
+        ::close(c.fd[0]);
+        ::close(c.fd[1]);
+        return false;
+    }
+    return true;
+}
+
+} // namespace detail
+#endif
+
+/// Run every job, at most `limit` at a time (0 = all at once), and capture
+/// their stdout/stderr.  One thread multiplexes all pipes with poll().
+/// A job still running `timeout` after its start (0 = no limit) is killed
+/// and its result marked timed_out.  nullopt for a job that could not be
+/// started (and on Windows).
+inline std::vector<std::optional<HelpText>>
+capture_help(const std::vector<HelpJob>& jobs,
+             std::size_t limit = 0,
+             std::chrono::milliseconds timeout = std::chrono::seconds(10))
+{
+    std::vector<std::optional<HelpText>> results(jobs.size());
+#ifdef _WIN32
+    (void)limit;
+    (void)timeout;
+    return results;
+#else
+    using clock = std::chrono::steady_clock;
+    limit = limit ? limit : std::max<std::size_t>(1, jobs.size());
+    int null_in = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    std::vector<detail::HelpChild> running;
+    std::vector<pollfd> pfds;
+    std::vector<std::pair<std::size_t, int>> owners; // running index, stream
+    std::size_t next = 0;
+    char buf[16 * 1024];
+
+    while (next < jobs.size() || !running.empty()) {
+        while (next < jobs.size() && running.size() < limit) {
+            detail::HelpChild c;
+            c.index = next++;
+            c.deadline = timeout.count() > 0 ? clock::now() + timeout : clock::time_point::max();
+            if (detail::start_help(jobs[c.index], null_in, c)) {
+                results[c.index].emplace();
+                running.push_back(c);
+            }
+        }
+
+        pfds.clear();
+        owners.clear();
+        auto first_deadline = clock::time_point::max();
+        for (std::size_t r = 0; r < running.size(); ++r) {
+            first_deadline = std::min(first_deadline, running[r].deadline);
+            for (int s = 0; s < 2; ++s) {
+                if (running[r].fd[s] >= 0) {
+                    pfds.push_back({running[r].fd[s], POLLIN, 0});
+                    owners.emplace_back(r, s);
+                }
+            }
+        }
+        int wait_ms = -1;
+        if (first_deadline != clock::time_point::max()) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(first_deadline - clock::now());
+            wait_ms = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+        }
+        if (!pfds.empty() && ::poll(pfds.data(), pfds.size(), wait_ms) < 0 && errno != EINTR) {
+            break;
+        }
+        for (std::size_t p = 0; p < pfds.size(); ++p) {
+            if (!(pfds[p].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            auto [r, s] = owners[p];
+            auto& c = running[r];
+            auto n = ::read(c.fd[s], buf, sizeof buf);
+            if (n > 0) {
+                auto& text = *results[c.index];
+                (s == 0 ? text.out : text.err).append(buf, static_cast<std::size_t>(n));
+            } else if (n == 0 || errno != EINTR) {
+                ::close(c.fd[s]);
+                c.fd[s] = -1;
+            }
+        }
+
+        // Both pipes closed: the child is done (or detached its output).
+        // Past its deadline: kill it and keep what it printed so far.
+        auto now = clock::now();
+        for (std::size_t r = running.size(); r-- > 0;) {
+            auto& c = running[r];
+            bool done = c.fd[0] < 0 && c.fd[1] < 0;
+            if (!done && now >= c.deadline) {
+                kill_process(c.pid);
+                for (int& fd : c.fd) {
+                    if (fd >= 0) {
+                        ::close(fd);
+                        fd = -1;
+                    }
+                }
+                results[c.index]->timed_out = true;
+                done = true;
+            }
+            if (done) {
+                results[c.index]->exit_code = wait_for(c.pid);
+                running.erase(running.begin() + static_cast<std::ptrdiff_t>(r));
+            }
+        }
+    }
+    if (null_in >= 0) {
+        ::close(null_in);
+    }
+    return results;
+#endif
+}
+
+// ── Cache ───────────────────────────────────────────────────
+
+/// A cache entry as found on disk.  The views point into the entry's
+/// buffer and live as long as this object.
+struct CachedHelp
+{
+    enum class State
+    {
+        Missing, ///< no usable entry
+        Fresh,   ///< stamp matches the plugin
+        Stale,   ///< plugin changed since; contents are the previous help
+    };
+
+    State state = State::Missing;
+    std::string_view out;
+    std::string_view err;
+    int exit_code = 0;
+    MappedFile file;
+};
+
+class HelpCache
+{
+public:
+    /// Entries live under `dir` (normally cache_dir() / "help").  An
+    /// empty dir disables the cache: lookups miss, stores do nothing.
+    explicit HelpCache(fs::path dir)
+        : dir_(std::move(dir))
+    {
+    }
+
+    /// The entry for `command` served by `plugin`, whose current identity
+    /// is `stamp`.
+    [[nodiscard]] CachedHelp
+    lookup(std::string_view command, const fs::path& plugin, const FileStamp& stamp) const
+    {
+        CachedHelp c;
+        if (dir_.empty()) {
+            return c;
+        }
+        c.file = MappedFile::open(entry_path(command, plugin));
+        auto data = c.file.view();
+        Header h{};
+        if (data.size() < sizeof h) {
+            return c;
+        }
+        std::memcpy(&h, data.data(), sizeof h);
+        if (std::memcmp(h.magic, magic, sizeof magic) != 0 || h.version != format_version ||
+            sizeof h + h.path_size + h.command_size + h.out_size + h.err_size != data.size()) {
+            return c;
+        }
+        data.remove_prefix(sizeof h);
+        auto take = [&](std::uint64_t n) {
+            n = std::min<std::uint64_t>(n, data.size()); // sizes may wrap the sum above
+            auto v = data.substr(0, static_cast<std::size_t>(n));
+            data.remove_prefix(static_cast<std::size_t>(n));
+            return v;
+        };
+        // The file name is a hash: confirm it is really this command.
+        if (take(h.path_size) != plugin.string() || take(h.command_size) != command) {
+            return c;
+        }
+        c.out = take(h.out_size);
+        c.err = take(h.err_size);
+        c.exit_code = h.exit_code;
+        c.state = h.stamp == stamp ? CachedHelp::State::Fresh : CachedHelp::State::Stale;
+        return c;
+    }
+
+    /// Record `text` as the help of `command` at identity `stamp`.
+    bool store(std::string_view command,
+               const fs::path& plugin,
+               const FileStamp& stamp,
+               const HelpText& text) const
+    {
+        if (dir_.empty()) {
+            return false;
+        }
+        Header h{};
+        std::memcpy(h.magic, magic, sizeof magic);
+        h.version = format_version;
+        h.exit_code = text.exit_code;
+        h.stamp = stamp;
+        std::string path = plugin.string();
+        h.path_size = path.size();
+        h.command_size = command.size();
+        h.out_size = text.out.size();
+        h.err_size = text.err.size();
+
+        std::string bytes;
+        bytes.reserve(sizeof h + h.path_size + h.command_size + h.out_size + h.err_size);
+        bytes.append(reinterpret_cast<const char*>(&h), sizeof h);
+        bytes.append(path);
+        bytes.append(command);
+        bytes.append(text.out);
+        bytes.append(text.err);
+        return write_atomic(entry_path(command, plugin), bytes);
+    }
+
+private:
+    static constexpr char magic[8] = {'D', 'E', 'V', 'H', 'L', 'P', '\0', '\0'};
+    static constexpr std::uint32_t format_version = 1;
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t exit_code;
+        FileStamp stamp;
+        std::uint64_t path_size;
+        std::uint64_t command_size;
+        std::uint64_t out_size;
+        std::uint64_t err_size;
+    };
+
+    fs::path dir_;
+
+    [[nodiscard]] fs::path entry_path(std::string_view command, const fs::path& plugin) const
+    {
+        auto h = fnv1a64(command);
+        h = fnv1a64("\n", h);
+        h = fnv1a64(plugin.string(), h);
+        return dir_ / (to_hex(h) + ".help");
+    }
+};
+
+/// Start `self help --refresh <commands...>` detached from the terminal's
+/// streams and do not wait: the refresh outlives the `dev help` that
+/// served a stale entry.  Not available on Windows.
+inline bool start_help_refresh(const fs::path& self, const std::vector<std::string>& commands)
+{
+#ifdef _WIN32
+    (void)self;
+    (void)commands;
+    return false;
+#else
+    std::string exe = self.string();
+    std::vector<const char*> argv{exe.c_str(), "help", "--refresh"};
+    for (const auto& c : commands) {
+        argv.push_back(c.c_str());
+    }
+    argv.push_back(nullptr);
+
+    int null_fd = ::open("/dev/null", O_RDWR | O_CLOEXEC);
+    SpawnOptions so;
+    so.in = null_fd;
+    so.out = null_fd;
+    so.err = null_fd;
+    auto pid = start(exe.c_str(), argv.data(), so);
+    if (null_fd >= 0) {
+        ::close(null_fd);
+    }
+    return pid != -1;
+#endif
+}
+
+/// Whether a captured run is worth caching: it succeeded, or failed
+/// normally after printing something (usage on stderr, exit 2).  Crashes,
+/// signals, exec failures and runs killed at the deadline are not
+/// remembered.
+inline bool cacheable(const HelpText& text)
+{
+    if (text.timed_out) {
+        return false;
+    }
+    if (text.exit_code == 0) {
+        return true;
+    }
+    return text.exit_code > 0 && text.exit_code < 126 && !(text.out.empty() && text.err.empty());
+}
+
+/// Write a cached entry to stdout / stderr: one write() each.
+inline void write_help(std::string_view out, std::string_view err)
+{
+#ifdef _WIN32
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fwrite(err.data(), 1, err.size(), stderr);
+#else
+    std::fflush(nullptr);
+    detail::write_all(STDOUT_FILENO, out);
+    detail::write_all(STDERR_FILENO, err);
+#endif
+}
+
+} // namespace dev
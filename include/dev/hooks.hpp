@@ -0,0 +1,297 @@
+/**
+ * @file hooks.hpp
+ * @brief Pre/post command hooks from the `[hooks]` section of dev.toml.
+ *
+ *   [hooks]
+ *   pre.build = ["./scripts/codegen.sh"]             # before the plugin, blocking
+ *   pre.build.async = ["./scripts/warm-cache.sh"]    # alongside the plugin
+ *   post.build = ["./scripts/check-size.sh"]         # after the plugin, blocking
+ *   post.build.async = ["./scripts/upload-cache.sh"] # after the plugin, detached
+ *   timeout = 30                                     # seconds per blocking phase (0 = none)
+ *
+ * Each hook is a shell command with DEV_HOOK (pre/post), DEV_COMMAND and,
+ * for post hooks, DEV_EXIT_CODE in its environment.  The hooks of one
+ * phase start together, so a phase costs its slowest hook, not their sum.
+ * A failing or timed-out pre hook aborts the command; post hooks only
+ * warn.  Async hooks are detached (own session, not waited for) with
+ * their output appended to `hooks.log` in the cache dir.
+ */
+
+#pragma once
+
+#include "dev/cache.hpp"
+#include "dev/config.hpp"
+#include "dev/process.hpp"
+#include "dev/style.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// Hooks configured for one command.
+struct Hooks
+{
+    std::vector<std::string> pre;
+    std::vector<std::string> pre_async;
+    std::vector<std::string> post;
+    std::vector<std::string> post_async;
+    std::chrono::milliseconds timeout{30'000}; ///< per blocking phase, 0 = unlimited
+
+    [[nodiscard]] bool empty() const
+    {
+        return pre.empty() && pre_async.empty() && post.empty() && post_async.empty();
+    }
+
+    /// Whether anything has to run after the plugin (rules out exec).
+    [[nodiscard]] bool has_post() const
+    {
+        return !post.empty() || !post_async.empty();
+    }
+};
+
+/// The `[hooks]` entries for `command` (after alias resolution).
+inline Hooks load_hooks(const Config& cfg, std::string_view command)
+{
+    Hooks h;
+    std::string c(command);
+    h.pre = cfg.get_list("hooks", "pre." + c);
+    h.pre_async = cfg.get_list("hooks", "pre." + c + ".async");
+    h.post = cfg.get_list("hooks", "post." + c);
+    h.post_async = cfg.get_list("hooks", "post." + c + ".async");
+    if (auto t = cfg.get("hooks", "timeout"); !t.empty()) {
+        h.timeout = std::chrono::milliseconds(
+            static_cast<long long>(std::max(0.0, std::atof(t.c_str())) * 1000));
+    }
+    return h;
+}
+
+namespace detail {
+
+/// Current environment plus the hook variables.
+struct HookEnv
+{
+    std::vector<std::string> extra;
+    std::vector<char*> envp;
+
+    HookEnv(std::string_view phase, std::string_view command, std::optional<int> exit_code)
+    {
+        extra.push_back("DEV_HOOK=" + std::string(phase));
+        extra.push_back("DEV_COMMAND=" + std::string(command));
+        if (exit_code) {
+            extra.push_back("DEV_EXIT_CODE=" + std::to_string(*exit_code));
+        }
+#ifdef _WIN32
+        char** env = _environ;
+#else
+        char** env = environ;
+#endif
+        for (; env && *env; ++env) {
+            std::string_view e = *env;
+            if (!e.starts_with("DEV_HOOK=") && !e.starts_with("DEV_COMMAND=") &&
+                !e.starts_with("DEV_EXIT_CODE=")) {
+                envp.push_back(*env);
+            }
+        }
+        for (auto& e : extra) {
+            envp.push_back(e.data());
+        }
+        envp.push_back(nullptr);
+    }
+};
+
+/// Start every hook of a blocking phase at once and wait for all of them,
+/// at most `timeout` in total; stragglers are killed.
+///
+/// @return  0, the first failing hook's exit code, or 124 on timeout.
+inline int run_hook_phase(const std::vector<std::string>& hooks,
+                          std::string_view label,
+                          std::chrono::milliseconds timeout,
+                          const HookEnv& env)
+{
+    trace::Span span("hooks", label);
+    SpawnOptions opts;
+    opts.envp = env.envp.data();
+
+    std::vector<process_id> pids;
+    for (const auto& cmd : hooks) {
+        pids.push_back(start_shell(cmd, opts));
+    }
+
+    auto deadline = timeout.count() > 0 ? std::chrono::steady_clock::now() + timeout
+                                        : std::chrono::steady_clock::time_point::max();
+    int result = 0;
+    for (std::size_t i = 0; i < pids.size(); ++i) {
+        int rc = 127;
+        if (pids[i] != -1) {
+            if (auto done = wait_until(pids[i], deadline)) {
+                rc = *done;
+            } else {
+                kill_process(pids[i]);
+                wait_for(pids[i]);
+                std::println(stderr,
+                             "{} {} hook timed out after {}s: {}",
+                             style::yellow_text("dev:"),
+                             label,
+                             std::chrono::duration<double>(timeout).count(),
+                             hooks[i]);
+                rc = 124; // like timeout(1)
+            }
+        }
+        if (rc != 0 && result == 0) {
+            result = rc;
+        }
+    }
+    return result;
+}
+
+/// Where detached hooks write their output.
+inline fs::path hook_log_path()
+{
+    auto dir = cache_dir();
+    return dir.empty() ? fs::path{} : dir / "hooks.log";
+}
+
+/// Start hooks that nobody waits for: own session (POSIX), stdin from
+/// the null device, stdout/stderr appended to hooks.log.
+inline void start_detached_hooks(const std::vector<std::string>& hooks,
+                                 std::string_view label,
+                                 const HookEnv& env)
+{
+    auto log_path = hook_log_path();
+    std::error_code ec;
+    if (!log_path.empty()) {
+        fs::create_directories(log_path.parent_path(), ec);
+    }
+#ifdef _WIN32
+    int log = log_path.empty() ? -1
+                               : _wopen(log_path.c_str(),
+                                        _O_WRONLY | _O_CREAT | _O_APPEND | _O_NOINHERIT,
+                                        _S_IREAD | _S_IWRITE);
+    int null_in = _open("NUL", _O_RDONLY | _O_NOINHERIT);
+#else
+    int log = log_path.empty()
+                  ? -1
+                  : ::open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    int null_in = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+#endif
+    int out = log >= 0 ? log : null_in;
+
+    for (const auto& cmd : hooks) {
+        if (log >= 0) {
+            std::string header = "── " + std::string(label) + ": " + cmd + "\n";
+#ifdef _WIN32
+            _write(log, header.data(), static_cast<unsigned>(header.size()));
+#else
+            [[maybe_unused]] auto n = ::write(log, header.data(), header.size());
+#endif
+        }
+#ifdef _WIN32
+        // _P_NOWAIT children outlive dev; the handle is simply not waited on.
+        SpawnOptions opts{null_in, out, out, nullptr, env.envp.data()};
+        start_shell(cmd, opts);
+#else
+        // Double fork: the hook is reparented to init, so it is neither a
+        // zombie of dev nor killed with the terminal's process group.
+        std::fflush(nullptr);
+        pid_t mid = ::fork();
+        if (mid == 0) {
+            ::setsid();
+            SpawnOptions opts{null_in, out, out, nullptr, env.envp.data()};
+            ::_exit(start_shell(cmd, opts) == -1 ? 127 : 0);
+        }
+        if (mid > 0) {
+            wait_for(mid);
+        }
+#endif
+    }
+
+#ifdef _WIN32
+    if (log >= 0)
+        _close(log);
+    if (null_in >= 0)
+        _close(null_in);
+#else
+    if (log >= 0)
+        ::close(log);
+    if (null_in >= 0)
+        ::close(null_in);
+#endif
+}
+
+} // namespace detail
+
+/// Run the pre hooks of `command`: async ones are started detached, the
+/// blocking ones are waited for.
+///
+/// @return  0 to go ahead with the command, otherwise the exit code to
+///          return instead (first failing hook, 124 on timeout).
+inline int run_pre_hooks(const Hooks& hooks, std::string_view command)
+{
+    if (hooks.pre.empty() && hooks.pre_async.empty()) {
+        return 0;
+    }
+    detail::HookEnv env("pre", command, std::nullopt);
+    // Async first: they overlap the blocking hooks as well as the plugin.
+    if (!hooks.pre_async.empty()) {
+        detail::start_detached_hooks(hooks.pre_async, "pre." + std::string(command), env);
+    }
+    if (hooks.pre.empty()) {
+        return 0;
+    }
+    int rc = detail::run_hook_phase(hooks.pre, "pre." + std::string(command), hooks.timeout, env);
+    if (rc != 0) {
+        std::println(stderr,
+                     "{} pre.{} hook failed (exit {}), not running '{}'",
+                     style::red_text("dev:"),
+                     command,
+                     rc,
+                     command);
+    }
+    return rc;
+}
+
+/// Run the post hooks of `command`, which exited with `exit_code`.
+/// Failures are reported but do not change the command's exit code.
+inline void run_post_hooks(const Hooks& hooks, std::string_view command, int exit_code)
+{
+    if (!hooks.has_post()) {
+        return;
+    }
+    detail::HookEnv env("post", command, exit_code);
+    if (!hooks.post.empty()) {
+        int rc =
+            detail::run_hook_phase(hooks.post, "post." + std::string(command), hooks.timeout, env);
+        if (rc != 0) {
+            std::println(stderr,
+                         "{} post.{} hook failed (exit {})",
+                         style::yellow_text("dev:"),
+                         command,
+                         rc);
+        }
+    }
+    if (!hooks.post_async.empty()) {
+        detail::start_detached_hooks(hooks.post_async, "post." + std::string(command), env);
+    }
+}
+
+} // namespace dev
@@ -0,0 +1,422 @@
+/**
+ * @file index.hpp
+ * @brief Persistent, memory-mapped plugin index.
+ *
+ * Maps plugin name → plugin path + metadata for a given list of plugin
+ * dirs.  Metadata comes from plugins.toml, which overrides the plugin's
+ * own DEV_PLUGIN_META note (read from the file, see dev/plugin_meta.hpp).
+ * Building the index never runs or loads plugin code: listing and
+ * completion must be safe in a freshly cloned repo whose ./plugins holds
+ * untrusted binaries.
+ * The index is validated with one stat() per dir (st_dev/st_ino/mtime),
+ * one for plugins.toml and one per plugin, instead of a full directory
+ * scan.  A plugin overwritten in place leaves its dir's stamp alone, so
+ * each entry carries its file's stamp too; when only those differ, just
+ * the changed plugins' notes are re-read.  The index is rewritten with
+ * write-to-temp + rename so concurrent readers never observe a torn file.
+ *
+ * Layout (native endianness, all offsets relative to the string blob):
+ *
+ *   Header
+ *   DirRecord[dir_count]
+ *   EntryRecord[entry_count]   — sorted by name
+ *   char strings[strings_size]
+ */
+
+#pragma once
+
+#include "dev/cache.hpp"
+#include "dev/config.hpp"
+#include "dev/discovery.hpp"
+#include "dev/dispatcher.hpp"
+#include "dev/mmap.hpp"
+#include "dev/plugin_meta.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+class PluginIndex
+{
+public:
+    struct Entry
+    {
+        std::string_view name;
+        std::string_view path;
+        std::string_view description;
+        std::string_view version;
+        std::string_view flags;      ///< DEV_PLUGIN_META flags, e.g. "raw"
+        std::string_view completion; ///< space-separated completion words
+    };
+
+    /// Open the cached index for `dirs` + `meta` (plugins.toml), rebuilding
+    /// it if any stamp changed.  With `persist = false` the index is built
+    /// in memory only and the cache dir is never touched.
+    static PluginIndex
+    open(const std::vector<fs::path>& dirs, const fs::path& meta, bool persist = true)
+    {
+        fs::path file = persist ? index_path(dirs, meta) : fs::path{};
+
+        PluginIndex prev;
+        bool same_plugins = false;
+        if (!file.empty()) {
+            prev.map_ = MappedFile::open(file);
+            if (prev.attach(prev.map_.view()) && prev.fresh(dirs, meta)) {
+                if (prev.plugins_fresh()) {
+                    prev.cached_ = true;
+                    return prev;
+                }
+                same_plugins = true;
+            }
+        }
+
+        PluginIndex idx;
+        idx.owned_ = build(dirs, meta, idx.scans_, same_plugins ? &prev : nullptr);
+        idx.attach(idx.owned_);
+        if (!file.empty()) {
+            write_atomic(file, idx.owned_);
+        }
+        return idx;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return entry_count_;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return entry_count_ == 0;
+    }
+
+    [[nodiscard]] Entry operator[](std::size_t i) const
+    {
+        auto r = entry_at(i);
+        return {str(r.name_off, r.name_len),
+                str(r.path_off, r.path_len),
+                str(r.desc_off, r.desc_len),
+                str(r.version_off, r.version_len),
+                str(r.flags_off, r.flags_len),
+                str(r.completion_off, r.completion_len)};
+    }
+
+    /// Position of the first entry whose name is not less than `name`;
+    /// entries sharing a prefix start here and are contiguous.
+    [[nodiscard]] std::size_t lower_bound(std::string_view name) const
+    {
+        std::size_t lo = 0;
+        std::size_t hi = entry_count_;
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            auto r = entry_at(mid);
+            if (str(r.name_off, r.name_len) < name) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /// Binary search by plugin name.
+    [[nodiscard]] std::optional<Entry> find(std::string_view name) const
+    {
+        auto i = lower_bound(name);
+        if (i < entry_count_) {
+            if (auto e = (*this)[i]; e.name == name) {
+                return e;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// True if served from the on-disk cache without rescanning.
+    [[nodiscard]] bool from_cache() const
+    {
+        return cached_;
+    }
+
+    /// The directory scans of a rebuild (empty when served from the cache).
+    [[nodiscard]] const std::vector<DirScan>& scans() const
+    {
+        return scans_;
+    }
+
+private:
+    static constexpr char magic[8] = {'D', 'E', 'V', 'I', 'D', 'X', '\0', '\0'};
+    static constexpr std::uint32_t format_version = 3;
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t dir_count;
+        std::uint32_t entry_count;
+        std::uint32_t reserved;
+        FileStamp meta;
+        std::uint64_t strings_size;
+    };
+
+    struct DirRecord
+    {
+        FileStamp stamp;
+        std::uint32_t path_off;
+        std::uint32_t path_len;
+    };
+
+    struct EntryRecord
+    {
+        FileStamp stamp; ///< the plugin file's, when its note was read
+        std::uint32_t name_off;
+        std::uint32_t name_len;
+        std::uint32_t path_off;
+        std::uint32_t path_len;
+        std::uint32_t desc_off;
+        std::uint32_t desc_len;
+        std::uint32_t version_off;
+        std::uint32_t version_len;
+        std::uint32_t flags_off;
+        std::uint32_t flags_len;
+        std::uint32_t completion_off;
+        std::uint32_t completion_len;
+    };
+
+    MappedFile map_;
+    std::string owned_;
+    Header header_{};
+    std::size_t entry_count_ = 0;
+    bool cached_ = false;
+    std::vector<DirScan> scans_;
+
+    // Section offsets into base(); offsets rather than pointers so moving
+    // the index (and its owned buffer) never leaves them dangling.
+    std::size_t dirs_off_ = 0;
+    std::size_t entries_off_ = 0;
+    std::size_t strings_off_ = 0;
+
+    [[nodiscard]] const char* base() const
+    {
+        return map_.empty() ? owned_.data() : map_.data();
+    }
+
+    [[nodiscard]] DirRecord dir_at(std::size_t i) const
+    {
+        DirRecord d{};
+        std::memcpy(&d, base() + dirs_off_ + i * sizeof(DirRecord), sizeof d);
+        return d;
+    }
+
+    [[nodiscard]] EntryRecord entry_at(std::size_t i) const
+    {
+        EntryRecord r{};
+        std::memcpy(&r, base() + entries_off_ + i * sizeof(EntryRecord), sizeof r);
+        return r;
+    }
+
+    [[nodiscard]] std::string_view str(std::uint32_t off, std::uint32_t len) const
+    {
+        return {base() + strings_off_ + off, len};
+    }
+
+    static fs::path index_path(const std::vector<fs::path>& dirs, const fs::path& meta)
+    {
+        auto base = cache_dir();
+        if (base.empty()) {
+            return {};
+        }
+        auto h = fnv1a64(meta.string());
+        for (const auto& d : dirs) {
+            h = fnv1a64("\n", h);
+            h = fnv1a64(d.string(), h);
+        }
+        return base / ("plugins-" + to_hex(h) + ".idx");
+    }
+
+    /// Point the accessors at a serialized index.  Rejects anything
+    /// truncated, foreign, or out of bounds.
+    bool attach(std::string_view data)
+    {
+        if (data.size() < sizeof(Header)) {
+            return false;
+        }
+        std::memcpy(&header_, data.data(), sizeof(Header));
+        if (std::memcmp(header_.magic, magic, sizeof magic) != 0 ||
+            header_.version != format_version) {
+            return false;
+        }
+
+        auto expected = sizeof(Header) + std::size_t{header_.dir_count} * sizeof(DirRecord) +
+                        std::size_t{header_.entry_count} * sizeof(EntryRecord) +
+                        header_.strings_size;
+        if (expected != data.size()) {
+            return false;
+        }
+
+        dirs_off_ = sizeof(Header);
+        entries_off_ = dirs_off_ + std::size_t{header_.dir_count} * sizeof(DirRecord);
+        strings_off_ = entries_off_ + std::size_t{header_.entry_count} * sizeof(EntryRecord);
+        entry_count_ = header_.entry_count;
+
+        auto in_bounds = [&](std::uint32_t off, std::uint32_t len) {
+            return std::uint64_t{off} + len <= header_.strings_size;
+        };
+        for (std::size_t i = 0; i < header_.dir_count; ++i) {
+            auto d = dir_at(i);
+            if (!in_bounds(d.path_off, d.path_len)) {
+                return false;
+            }
+        }
+        for (std::size_t i = 0; i < entry_count_; ++i) {
+            auto r = entry_at(i);
+            if (!in_bounds(r.name_off, r.name_len) || !in_bounds(r.path_off, r.path_len) ||
+                !in_bounds(r.desc_off, r.desc_len) || !in_bounds(r.version_off, r.version_len) ||
+                !in_bounds(r.flags_off, r.flags_len) ||
+                !in_bounds(r.completion_off, r.completion_len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Same dirs, same order, and nothing changed since the index was built.
+    [[nodiscard]] bool fresh(const std::vector<fs::path>& dirs, const fs::path& meta) const
+    {
+        if (header_.dir_count != dirs.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < dirs.size(); ++i) {
+            auto d = dir_at(i);
+            if (str(d.path_off, d.path_len) != dirs[i].string() ||
+                d.stamp != stamp_of(dirs[i])) {
+                return false;
+            }
+        }
+        return header_.meta == (meta.empty() ? FileStamp{} : stamp_of(meta));
+    }
+
+    /// No plugin file replaced since its note was read.
+    [[nodiscard]] bool plugins_fresh() const
+    {
+        for (std::size_t i = 0; i < entry_count_; ++i) {
+            auto r = entry_at(i);
+            if (r.stamp != stamp_of(fs::path(str(r.path_off, r.path_len)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Scan the dirs (into `scans`) and serialize a fresh index.  With
+    /// `prev` — an index whose dirs and plugins.toml are unchanged — the
+    /// plugin list is taken from it instead, and so is the metadata of
+    /// every plugin whose file stamp still matches.
+    static std::string build(const std::vector<fs::path>& dirs,
+                             const fs::path& meta,
+                             std::vector<DirScan>& scans,
+                             const PluginIndex* prev = nullptr)
+    {
+        // Stamp before scanning: a change racing the scan then shows up
+        // as a mismatch on the next open rather than being lost.
+        Header h{};
+        std::memcpy(h.magic, magic, sizeof magic);
+        h.version = format_version;
+        h.meta = meta.empty() ? FileStamp{} : stamp_of(meta);
+
+        std::vector<DirRecord> dir_records;
+        std::string strings;
+        auto intern = [&](std::string_view s, std::uint32_t& off, std::uint32_t& len) {
+            off = static_cast<std::uint32_t>(strings.size());
+            len = static_cast<std::uint32_t>(s.size());
+            strings.append(s);
+        };
+
+        for (const auto& d : dirs) {
+            DirRecord r{};
+            r.stamp = stamp_of(d);
+            intern(d.string(), r.path_off, r.path_len);
+            dir_records.push_back(r);
+        }
+
+        // Sorted by name.  Without `prev`, one concurrent pass over the
+        // dirs; names and paths then come from the scans without further
+        // syscalls.
+        std::vector<std::pair<std::string, fs::path>> plugins;
+        if (prev) {
+            for (std::size_t i = 0; i < prev->size(); ++i) {
+                auto e = (*prev)[i];
+                plugins.emplace_back(e.name, e.path);
+            }
+        } else {
+            scans = scan_plugin_dirs(dirs);
+            for (auto& name : merge_plugin_names(scans)) {
+                auto path = resolve_plugin(name, scans);
+                plugins.emplace_back(std::move(name), std::move(path));
+            }
+        }
+
+        std::optional<Config> cfg; // loaded by the first note read
+        std::vector<EntryRecord> entry_records;
+        for (std::size_t i = 0; i < plugins.size(); ++i) {
+            const auto& [name, path] = plugins[i];
+            EntryRecord r{};
+            r.stamp = stamp_of(path); // before the read, as for the dirs
+            intern(name, r.name_off, r.name_len);
+            intern(path.string(), r.path_off, r.path_len);
+            if (prev && prev->entry_at(i).stamp == r.stamp) {
+                auto e = (*prev)[i];
+                intern(e.description, r.desc_off, r.desc_len);
+                intern(e.version, r.version_off, r.version_len);
+                intern(e.flags, r.flags_off, r.flags_len);
+                intern(e.completion, r.completion_off, r.completion_len);
+                entry_records.push_back(r);
+                continue;
+            }
+            if (!cfg) {
+                cfg.emplace();
+                if (!meta.empty()) {
+                    trace::Span span("plugins.toml load", meta.string());
+                    *cfg = Config::load(meta);
+                }
+            }
+            // The note costs a header parse; plugins.toml wins field by field.
+            auto note = read_plugin_meta(path).value_or(PluginMeta{});
+            auto pick = [&](std::string_view key, const std::string& own) {
+                auto v = cfg->value(name, key);
+                return v && !v->empty() ? *v : std::string_view(own);
+            };
+            intern(pick("description", note.description), r.desc_off, r.desc_len);
+            intern(pick("version", note.version), r.version_off, r.version_len);
+            intern(note.flags, r.flags_off, r.flags_len);
+            intern(pick("completion", note.completion), r.completion_off, r.completion_len);
+            entry_records.push_back(r);
+        }
+
+        h.dir_count = static_cast<std::uint32_t>(dir_records.size());
+        h.entry_count = static_cast<std::uint32_t>(entry_records.size());
+        h.strings_size = strings.size();
+
+        std::string out;
+        out.reserve(sizeof h + dir_records.size() * sizeof(DirRecord) +
+                    entry_records.size() * sizeof(EntryRecord) + strings.size());
+        out.append(reinterpret_cast<const char*>(&h), sizeof h);
+        out.append(reinterpret_cast<const char*>(dir_records.data()),
+                   dir_records.size() * sizeof(DirRecord));
+        out.append(reinterpret_cast<const char*>(entry_records.data()),
+                   entry_records.size() * sizeof(EntryRecord));
+        out.append(strings);
+        return out;
+    }
+};
+
+} // namespace dev
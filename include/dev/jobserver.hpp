@@ -0,0 +1,326 @@
+/**
+ * @file jobserver.hpp
+ * @brief GNU make jobserver (client and server) for one shared CPU budget.
+ *
+ * A jobserver is a pipe (or, since make 4.4, a named fifo) holding one
+ * byte per job slot beyond the implicit one every process already owns.
+ * Tools that understand it — make, cargo, ninja ≥ 1.13, cmake --build via
+ * those — read a byte before starting extra work and write it back after,
+ * so everything below one jobserver shares a single concurrency budget.
+ *
+ * dev either joins the jobserver it inherited from MAKEFLAGS or, when
+ * `[jobserver] jobs` / `DEV_JOBS` asks for one, creates a pipe and
+ * advertises it to every plugin via MAKEFLAGS and CARGO_MAKEFLAGS.
+ * POSIX only; on Windows (make uses named semaphores there) every call is
+ * a no-op.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+class Jobserver
+{
+public:
+    Jobserver() = default;
+
+    Jobserver(Jobserver&& other) noexcept
+        : read_fd_(std::exchange(other.read_fd_, -1))
+        , write_fd_(std::exchange(other.write_fd_, -1))
+        , poll_fd_(std::exchange(other.poll_fd_, -1))
+        , owner_(std::exchange(other.owner_, false))
+        , slots_(other.slots_)
+        , held_(std::move(other.held_))
+    {
+    }
+
+    Jobserver& operator=(Jobserver&& other) noexcept
+    {
+        if (this != &other) {
+            release_all();
+            close_fds();
+            read_fd_ = std::exchange(other.read_fd_, -1);
+            write_fd_ = std::exchange(other.write_fd_, -1);
+            poll_fd_ = std::exchange(other.poll_fd_, -1);
+            owner_ = std::exchange(other.owner_, false);
+            slots_ = other.slots_;
+            held_ = std::move(other.held_);
+        }
+        return *this;
+    }
+
+    Jobserver(const Jobserver&) = delete;
+    Jobserver& operator=(const Jobserver&) = delete;
+
+    ~Jobserver()
+    {
+        release_all();
+        close_fds();
+    }
+
+    // ── Factory ─────────────────────────────────────────────
+
+    /// Join the jobserver advertised in MAKEFLAGS (`--jobserver-auth=R,W`,
+    /// `--jobserver-fds=R,W` or `--jobserver-auth=fifo:PATH`), if usable.
+    static std::optional<Jobserver> from_env()
+    {
+#ifdef _WIN32
+        return std::nullopt;
+#else
+        const char* flags = std::getenv("MAKEFLAGS");
+        if (!flags) {
+            return std::nullopt;
+        }
+        auto auth = parse_auth(flags);
+        if (auth.empty()) {
+            return std::nullopt;
+        }
+
+        Jobserver js;
+        if (auth.starts_with("fifo:")) {
+            std::string path(auth.substr(5));
+            // O_RDWR: opening one end of a fifo alone would block.
+            js.read_fd_ = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+            js.write_fd_ = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+            js.poll_fd_ = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            js.owner_ = true; // our own descriptors, close them
+        } else {
+            auto comma = auth.find(',');
+            if (comma == std::string_view::npos) {
+                return std::nullopt;
+            }
+            js.read_fd_ = std::atoi(std::string(auth.substr(0, comma)).c_str());
+            js.write_fd_ = std::atoi(std::string(auth.substr(comma + 1)).c_str());
+            // make closes the fds for commands it does not consider
+            // recursive; a stale MAKEFLAGS must not be trusted.
+            if (js.read_fd_ < 0 || js.write_fd_ < 0 || ::fcntl(js.read_fd_, F_GETFD) < 0 ||
+                ::fcntl(js.write_fd_, F_GETFD) < 0) {
+                js.read_fd_ = js.write_fd_ = -1;
+                return std::nullopt;
+            }
+            js.poll_fd_ = nonblocking_reader(js.read_fd_);
+        }
+        if (js.read_fd_ < 0 || js.write_fd_ < 0) {
+            return std::nullopt;
+        }
+        return js;
+#endif
+    }
+
+    /// Create a jobserver with `slots` total job slots (>= 1).  The caller
+    /// owns the implicit slot; `slots - 1` tokens go into the pipe.
+    static std::optional<Jobserver> create(std::size_t slots)
+    {
+#ifdef _WIN32
+        (void)slots;
+        return std::nullopt;
+#else
+        int fds[2];
+        // Inheritable on purpose: plugins and their make/cargo use them.
+        if (slots == 0 || ::pipe(fds) != 0) {
+            return std::nullopt;
+        }
+        Jobserver js;
+        js.read_fd_ = fds[0];
+        js.write_fd_ = fds[1];
+        js.owner_ = true;
+        js.slots_ = slots;
+        std::string tokens(slots - 1, '+');
+        for (std::string_view rest = tokens; !rest.empty();) {
+            auto n = ::write(js.write_fd_, rest.data(), rest.size());
+            if (n <= 0) {
+                return std::nullopt;
+            }
+            rest.remove_prefix(static_cast<std::size_t>(n));
+        }
+        js.poll_fd_ = nonblocking_reader(js.read_fd_);
+        return js;
+#endif
+    }
+
+    /// Advertise this jobserver to child processes (MAKEFLAGS for make and
+    /// ninja, CARGO_MAKEFLAGS for cargo).  Only meaningful for a jobserver
+    /// created here; an inherited one is already in the environment.
+    void export_env() const
+    {
+#ifndef _WIN32
+        if (slots_ == 0) {
+            return;
+        }
+        auto fds = std::to_string(read_fd_) + "," + std::to_string(write_fd_);
+        // -j<N> plus both spellings: make < 4.2 only knows --jobserver-fds.
+        auto ours = "-j" + std::to_string(slots_) + " --jobserver-fds=" + fds +
+                    " --jobserver-auth=" + fds;
+
+        // Appended: make reads a leading dash-less word as short options.
+        std::string flags;
+        if (const char* old = std::getenv("MAKEFLAGS")) {
+            flags = strip_jobserver(old);
+        }
+        flags = flags.empty() ? ours : flags + " " + ours;
+        ::setenv("MAKEFLAGS", flags.c_str(), 1);
+        ::setenv("CARGO_MAKEFLAGS", flags.c_str(), 1);
+#endif
+    }
+
+    // ── Tokens ──────────────────────────────────────────────
+
+    /// Take a token if one is available right now.
+    bool try_acquire()
+    {
+#ifdef _WIN32
+        return false;
+#else
+        char c = 0;
+        if (poll_fd_ >= 0) {
+            if (::read(poll_fd_, &c, 1) == 1) {
+                held_.push_back(c);
+                return true;
+            }
+            return false;
+        }
+        // No private non-blocking descriptor: poll + read.  Another
+        // client may win the race, in which case read() blocks until the
+        // next token — still correct, just not instant.
+        pollfd p{read_fd_, POLLIN, 0};
+        if (::poll(&p, 1, 0) == 1 && ::read(read_fd_, &c, 1) == 1) {
+            held_.push_back(c);
+            return true;
+        }
+        return false;
+#endif
+    }
+
+    /// Return one previously acquired token.
+    void release()
+    {
+#ifndef _WIN32
+        if (held_.empty()) {
+            return;
+        }
+        char c = held_.back();
+        held_.pop_back();
+        while (::write(write_fd_, &c, 1) < 0 && errno == EINTR) {
+        }
+#endif
+    }
+
+    /// Return every token still held (also done on destruction).
+    void release_all()
+    {
+        while (!held_.empty()) {
+            release();
+        }
+    }
+
+    /// Descriptor that becomes readable when a token may be available,
+    /// for inclusion in a poll() set.
+    [[nodiscard]] int wait_fd() const
+    {
+        return poll_fd_ >= 0 ? poll_fd_ : read_fd_;
+    }
+
+    /// Tokens currently held by this process.
+    [[nodiscard]] std::size_t held() const
+    {
+        return held_.size();
+    }
+
+    /// Total slots if created here, 0 if joined from the environment.
+    [[nodiscard]] std::size_t slots() const
+    {
+        return slots_;
+    }
+
+private:
+    int read_fd_ = -1;
+    int write_fd_ = -1;
+    int poll_fd_ = -1; ///< private O_NONBLOCK reader, -1 if unavailable
+    bool owner_ = false;
+    std::size_t slots_ = 0;
+    std::vector<char> held_;
+
+    void close_fds()
+    {
+#ifndef _WIN32
+        if (poll_fd_ >= 0) {
+            ::close(poll_fd_);
+        }
+        if (owner_) {
+            if (read_fd_ >= 0) {
+                ::close(read_fd_);
+            }
+            if (write_fd_ >= 0) {
+                ::close(write_fd_);
+            }
+        }
+#endif
+        read_fd_ = write_fd_ = poll_fd_ = -1;
+    }
+
+#ifndef _WIN32
+    /// A second, non-blocking open file description of the same pipe.
+    /// O_NONBLOCK on the shared one would leak into make and cargo; on
+    /// Linux /proc/self/fd gives a fresh description instead.
+    static int nonblocking_reader([[maybe_unused]] int fd)
+    {
+#ifdef __linux__
+        auto path = "/proc/self/fd/" + std::to_string(fd);
+        return ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+#else
+        return -1;
+#endif
+    }
+#endif
+
+    /// The value of the last --jobserver-auth= / --jobserver-fds= word.
+    static std::string_view parse_auth(std::string_view flags)
+    {
+        std::string_view found;
+        for (std::string_view key : {"--jobserver-fds=", "--jobserver-auth="}) {
+            auto pos = flags.rfind(key);
+            if (pos == std::string_view::npos) {
+                continue;
+            }
+            auto value = flags.substr(pos + key.size());
+            found = value.substr(0, value.find(' '));
+        }
+        return found;
+    }
+
+    /// MAKEFLAGS without any -j / jobserver words.
+    static std::string strip_jobserver(std::string_view flags)
+    {
+        std::string out;
+        while (!flags.empty()) {
+            auto sp = flags.find(' ');
+            auto word = flags.substr(0, sp);
+            flags = (sp == std::string_view::npos) ? std::string_view{} : flags.substr(sp + 1);
+            if (word.empty() || word.starts_with("--jobserver-") || word.starts_with("-j")) {
+                continue;
+            }
+            if (!out.empty()) {
+                out += ' ';
+            }
+            out += word;
+        }
+        return out;
+    }
+};
+
+} // namespace dev
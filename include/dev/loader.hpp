@@ -0,0 +1,239 @@
+/**
+ * @file loader.hpp
+ * @brief Host side of the shared-library plugin ABI (see dev/plugin.hpp).
+ *
+ * A shared plugin runs inside dev: dlopen() + one call, no fork/exec and no
+ * second dynamic-loader startup.  With crash isolation it runs in a forked
+ * child instead (still no exec), so a crashing plugin cannot take dev down
+ * and the parent can account for it with wait4().
+ *
+ * Libraries stay loaded until exit: a plugin may register atexit handlers
+ * or leave threads behind, and dev exits right after the plugin anyway.
+ */
+
+#pragma once
+
+#include "dev/plugin.hpp"
+#include "dev/process.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// File extension of shared-library plugins on this platform.
+#if defined(_WIN32)
+inline constexpr std::string_view shared_plugin_ext = ".dll";
+#elif defined(__APPLE__)
+inline constexpr std::string_view shared_plugin_ext = ".dylib";
+#else
+inline constexpr std::string_view shared_plugin_ext = ".so";
+#endif
+
+/// True if `plugin` (as returned by resolve_plugin) is a shared library.
+inline bool is_shared_plugin(const fs::path& plugin)
+{
+    std::string_view native_ext = shared_plugin_ext;
+    const auto& s = plugin.native();
+    if (s.size() <= native_ext.size()) {
+        return false;
+    }
+    auto tail = s.substr(s.size() - native_ext.size());
+    return std::equal(tail.begin(), tail.end(), native_ext.begin());
+}
+
+/// Load a shared plugin and validate its v1 entry point.
+///
+/// @return  The plugin's info, or nullptr with `error` set (names the file).
+inline const dev_plugin_info_v1* load_shared_plugin(const fs::path& path, std::string& error)
+{
+    trace::Span span("dlopen", path.string());
+#ifdef _WIN32
+    HMODULE lib = ::LoadLibraryW(path.c_str());
+    if (!lib) {
+        error = path.string() + ": cannot load (error " + std::to_string(::GetLastError()) + ")";
+        return nullptr;
+    }
+    auto entry = reinterpret_cast<dev_plugin_entry_v1>(::GetProcAddress(lib, DEV_PLUGIN_ENTRY_V1));
+#else
+    void* lib = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        const char* why = ::dlerror(); // already names the file
+        error = why ? why : path.string() + ": cannot load";
+        return nullptr;
+    }
+    auto entry = reinterpret_cast<dev_plugin_entry_v1>(::dlsym(lib, DEV_PLUGIN_ENTRY_V1));
+#endif
+    if (!entry) {
+        error = path.string() + ": no " DEV_PLUGIN_ENTRY_V1 "() entry point";
+        return nullptr;
+    }
+    const dev_plugin_info_v1* info = entry();
+    // `size` lets later releases append fields without a new entry point.
+    if (!info || info->abi_version != DEV_PLUGIN_ABI_VERSION ||
+        info->size < sizeof(dev_plugin_info_v1) || !info->run) {
+        error = path.string() + ": unsupported plugin ABI (expected v" +
+                std::to_string(DEV_PLUGIN_ABI_VERSION) + ")";
+        return nullptr;
+    }
+    return info;
+}
+
+namespace detail {
+
+/// Call a loaded plugin in the calling process.
+inline int invoke_plugin(const dev_plugin_info_v1& info, const char* const* argv, char** envp)
+{
+    int argc = 0;
+    while (argv[argc]) {
+        ++argc;
+    }
+    const dev_plugin_io io{0, 1, 2};
+    trace::Span span("run", info.name ? info.name : "");
+    int rc = info.run(argc, const_cast<char**>(argv), envp, &io);
+    std::fflush(nullptr);
+    return rc;
+}
+
+/// Load and run in the calling process; 126 if the plugin is unusable.
+inline int run_shared_here(const fs::path& path, const char* const* argv, char** envp)
+{
+    std::string error;
+    const auto* info = load_shared_plugin(path, error);
+    if (!info) {
+        std::println(stderr, "dev: {}", error);
+        return 126;
+    }
+    return invoke_plugin(*info, argv, envp);
+}
+
+#ifndef _WIN32
+/// fork(), apply `opts` in the child like start() would, then `_exit(body())`
+/// — an in-process plugin in its own process, without exec.
+template <typename Body>
+inline pid_t fork_run(const SpawnOptions& opts, Body&& body)
+{
+    std::fflush(nullptr); // or buffered output is written twice
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        if (opts.in >= 0)
+            ::dup2(opts.in, STDIN_FILENO);
+        if (opts.out >= 0)
+            ::dup2(opts.out, STDOUT_FILENO);
+        if (opts.err >= 0)
+            ::dup2(opts.err, STDERR_FILENO);
+        if (opts.cwd && ::chdir(opts.cwd) != 0)
+            ::_exit(126);
+        if (opts.envp)
+            environ = const_cast<char**>(opts.envp);
+        // _exit: the parent's atexit handlers (trace close, ...) are not ours.
+        ::_exit(body());
+    }
+    return pid;
+}
+
+/// fork_run() + wait, measuring like spawn() does.
+template <typename Body>
+inline int fork_run_wait(const std::string& label, ResourceUsage* usage, Body&& body)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    pid_t pid = -1;
+    {
+        trace::Span span("spawn", "fork (in-process plugin)");
+        pid = fork_run({}, std::forward<Body>(body));
+    }
+    if (pid == -1) {
+        return -1;
+    }
+    trace::Span span("wait", label);
+    int rc = wait_for(pid, usage);
+    if (usage) {
+        usage->wall_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return rc;
+}
+#endif
+
+} // namespace detail
+
+/// Start a shared plugin in a forked child (crash isolation).
+///
+/// The child applies `opts` like start() would, then loads and runs the
+/// plugin and exits with its return code — no exec.  Windows has no fork,
+/// so this fails there (-1); use run_shared_plugin() instead.
+inline process_id
+start_shared_plugin(const fs::path& path, const char* const* argv, const SpawnOptions& opts = {})
+{
+#ifdef _WIN32
+    (void)path;
+    (void)argv;
+    (void)opts;
+    return -1;
+#else
+    return detail::fork_run(opts, [&] { return detail::run_shared_here(path, argv, environ); });
+#endif
+}
+
+/// Start a plugin of either kind without waiting for it: executables via
+/// start(), shared libraries in a forked child.
+inline process_id
+start_plugin(const fs::path& plugin, const char* const* argv, const SpawnOptions& opts = {})
+{
+    if (is_shared_plugin(plugin)) {
+        return start_shared_plugin(plugin, argv, opts);
+    }
+    return start(plugin.string().c_str(), argv, opts);
+}
+
+/// Run a shared plugin and return its exit code.
+///
+/// @param isolate  Run it in a forked child and wait (POSIX), so a crash
+///                 is reported as an exit code instead of killing dev.
+///                 Required for `usage`, which needs a child to measure.
+inline int run_shared_plugin(const fs::path& path,
+                             int argc,
+                             char* argv[],
+                             int arg_offset = 2,
+                             bool isolate = false,
+                             ResourceUsage* usage = nullptr)
+{
+    std::string path_str = path.string();
+    auto child_argv = make_argv(path_str, argc, argv, arg_offset);
+
+#ifndef _WIN32
+    if (isolate || usage) {
+        return detail::fork_run_wait(path_str, usage, [&] {
+            return detail::run_shared_here(path, child_argv.data(), environ);
+        });
+    }
+    return detail::run_shared_here(path, child_argv.data(), environ);
+#else
+    (void)isolate;
+    (void)usage;
+    return detail::run_shared_here(path, child_argv.data(), _environ);
+#endif
+}
+
+} // namespace dev
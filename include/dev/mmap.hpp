@@ -0,0 +1,182 @@
+/**
+ * @file mmap.hpp
+ * @brief Read-only memory-mapped files (plain read fallback on Windows).
+ *
+ * Files below `MappedFile::map_threshold` are read into an owned buffer
+ * instead: for a few KiB, one read() is cheaper than mmap() plus the page
+ * fault and the munmap() that follow.
+ */
+
+#pragma once
+
+#include "dev/cache.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// A whole file mapped read-only into memory.  Move-only; the bytes do
+/// not move with the object.
+class MappedFile
+{
+public:
+    /// Smaller files are read, not mapped.
+    static constexpr std::size_t map_threshold = 64 * 1024;
+
+    MappedFile() = default;
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , open_(std::exchange(other.open_, false))
+        , buffer_(std::move(other.buffer_))
+    {
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            open_ = std::exchange(other.open_, false);
+            buffer_ = std::move(other.buffer_);
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        release();
+    }
+
+    /// Map a file.  Returns an empty MappedFile if it cannot be opened
+    /// or is empty; is_open() tells the two apart.  `stamp`, if given,
+    /// receives the identity of the file actually opened.
+    static MappedFile open(const fs::path& path, FileStamp* stamp = nullptr)
+    {
+        MappedFile m;
+#ifdef _WIN32
+        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+        if (!ifs.is_open()) {
+            return m;
+        }
+        m.open_ = true;
+        if (stamp) {
+            *stamp = stamp_of(path);
+        }
+        auto size = static_cast<std::size_t>(ifs.tellg());
+        if (size > 0) {
+            m.buffer_ = std::make_unique_for_overwrite<char[]>(size);
+            ifs.seekg(0);
+            ifs.read(m.buffer_.get(), static_cast<std::streamsize>(size));
+            m.data_ = m.buffer_.get();
+            m.size_ = static_cast<std::size_t>(ifs.gcount());
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return m;
+        }
+        m.open_ = true;
+        struct stat st{};
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && stamp) {
+            *stamp = stamp_of(st);
+        }
+        if (ok && st.st_size > 0) {
+            auto size = static_cast<std::size_t>(st.st_size);
+            if (size < map_threshold) {
+                m.buffer_ = std::make_unique_for_overwrite<char[]>(size);
+                std::size_t got = 0;
+                while (got < size) {
+                    auto n = ::read(fd, m.buffer_.get() + got, size - got);
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += static_cast<std::size_t>(n);
+                }
+                m.data_ = m.buffer_.get();
+                m.size_ = got;
+            } else {
+                void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    m.data_ = static_cast<const char*>(p);
+                    m.size_ = size;
+                }
+            }
+        }
+        ::close(fd);
+#endif
+        return m;
+    }
+
+    [[nodiscard]] std::string_view view() const
+    {
+        return {data_, size_};
+    }
+
+    [[nodiscard]] const char* data() const
+    {
+        return data_;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return size_;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /// Whether the file could be opened (it may still be empty).
+    [[nodiscard]] bool is_open() const
+    {
+        return open_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool open_ = false;
+    std::unique_ptr<char[]> buffer_; ///< read (not mapped) contents
+
+    void release()
+    {
+#ifndef _WIN32
+        if (data_ && !buffer_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        buffer_.reset();
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+};
+
+} // namespace dev
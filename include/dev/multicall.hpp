@@ -0,0 +1,108 @@
+/**
+ * @file multicall.hpp
+ * @brief Bundled plugins compiled into the dev binary (busybox-style).
+ *
+ * With the DEV_MULTICALL CMake option the examples/ plugins are built into
+ * dev itself (each through DEV_PLUGIN_MAIN with DEV_PLUGIN_BUILTIN) and
+ * listed in the generated dev/multicall_table.hpp.  They are dispatched
+ * by name before any plugin-dir lookup and run in-process through the
+ * same v1 ABI as shared-library plugins — no exec, no second libstdc++
+ * startup.  A plugin dir still wins for names listed in
+ * `[plugins] override`.  Without DEV_MULTICALL the table is empty.
+ */
+
+#pragma once
+
+#include "dev/config.hpp"
+#include "dev/loader.hpp"
+#include "dev/plugin.hpp"
+#include "dev/process.hpp"
+
+#include <algorithm>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dev {
+
+/// A plugin compiled into dev.
+struct BundledPlugin
+{
+    std::string_view name;
+    dev_plugin_entry_v1 entry;
+};
+
+} // namespace dev
+
+#ifdef DEV_MULTICALL
+#include "dev/multicall_table.hpp" // needs BundledPlugin
+#endif
+
+namespace dev {
+
+/// All bundled plugins, sorted by name.
+inline std::span<const BundledPlugin> bundled_plugins()
+{
+#ifdef DEV_MULTICALL
+    return detail::multicall_table;
+#else
+    return {};
+#endif
+}
+
+/// Look up a bundled plugin by command name.
+inline const BundledPlugin* find_bundled_plugin(std::string_view name)
+{
+    auto all = bundled_plugins();
+    auto it = std::lower_bound(all.begin(), all.end(), name, [](const auto& p, std::string_view n) {
+        return p.name < n;
+    });
+    return (it != all.end() && it->name == name) ? &*it : nullptr;
+}
+
+/// Like find_bundled_plugin(), but nullptr when `cfg` hands the name to a
+/// plugin dir (`[plugins] override = ["build", ...]`).
+inline const BundledPlugin* find_bundled_plugin(std::string_view name, const Config& cfg)
+{
+    const auto* p = find_bundled_plugin(name);
+    if (!p) {
+        return nullptr;
+    }
+    for (const auto& o : cfg.get_list("plugins", "override")) {
+        if (o == name) {
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+/// Run a bundled plugin; `argv[0]` is the command name.
+///
+/// @param isolate  Run it in a forked child and wait (POSIX), so a crash
+///                 is an exit code.  Implied by `usage`.
+inline int run_bundled_plugin(const BundledPlugin& plugin,
+                              int argc,
+                              char* argv[],
+                              bool isolate = false,
+                              ResourceUsage* usage = nullptr)
+{
+    const dev_plugin_info_v1& info = *plugin.entry();
+    std::vector<const char*> child_argv(argv, argv + argc);
+    child_argv.push_back(nullptr);
+
+#ifndef _WIN32
+    if (isolate || usage) {
+        return detail::fork_run_wait(std::string(plugin.name), usage, [&] {
+            return detail::invoke_plugin(info, child_argv.data(), environ);
+        });
+    }
+    return detail::invoke_plugin(info, child_argv.data(), environ);
+#else
+    (void)isolate;
+    (void)usage;
+    return detail::invoke_plugin(info, child_argv.data(), _environ);
+#endif
+}
+
+} // namespace dev
@@ -0,0 +1,102 @@
+/**
+ * @file output.hpp
+ * @brief Build a whole screen of output in memory and emit it at once.
+ *
+ * std::println flushes per line on a terminal, so a listing of N plugins
+ * costs N write() calls.  OutputBuffer formats into one string instead
+ * and hands it to the kernel in a single write() when flushed (or
+ * destroyed).  Anything printed to the same stream before is flushed
+ * first, so ordering is preserved.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+class OutputBuffer
+{
+public:
+    explicit OutputBuffer(std::FILE* stream = stdout)
+        : stream_(stream)
+    {
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    ~OutputBuffer()
+    {
+        flush();
+    }
+
+    template <typename... Args>
+    void print(std::format_string<Args...> fmt, Args&&... args)
+    {
+        std::format_to(std::back_inserter(buf_), fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void println(std::format_string<Args...> fmt, Args&&... args)
+    {
+        print(fmt, std::forward<Args>(args)...);
+        buf_ += '\n';
+    }
+
+    void println()
+    {
+        buf_ += '\n';
+    }
+
+    /// Emit everything buffered so far.
+    void flush()
+    {
+        if (buf_.empty()) {
+            return;
+        }
+        std::fflush(stream_);
+#ifdef _WIN32
+        // The CRT handles console encoding; one fwrite is one WriteFile.
+        std::fwrite(buf_.data(), 1, buf_.size(), stream_);
+        std::fflush(stream_);
+#else
+        int fd = fileno(stream_);
+        std::string_view rest = buf_;
+        while (!rest.empty()) {
+            auto n = ::write(fd, rest.data(), rest.size());
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            rest.remove_prefix(static_cast<std::size_t>(n));
+        }
+#endif
+        buf_.clear();
+    }
+
+    [[nodiscard]] std::string_view view() const
+    {
+        return buf_;
+    }
+
+private:
+    std::FILE* stream_;
+    std::string buf_;
+};
+
+} // namespace dev
@@ -0,0 +1,443 @@
+/**
+ * @file parallel.hpp
+ * @brief Run several plugin commands concurrently (`dev par`).
+ *
+ * Each command's stdout/stderr is captured through pipes and either
+ * re-emitted line by line with a `name | ` prefix (one write() per batch
+ * of complete lines, so lines never tear) or buffered and printed as one
+ * block when the command finishes.  On Windows, where there is no poll()
+ * on pipes, commands run one after another with inherited output.
+ */
+
+#pragma once
+
+#include "dev/jobserver.hpp"
+#include "dev/loader.hpp"
+#include "dev/process.hpp"
+#include "dev/style.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// One command of a parallel run.
+struct ParallelJob
+{
+    std::string name;              ///< label used as output prefix
+    fs::path exe;                  ///< resolved plugin executable
+    std::vector<std::string> args; ///< arguments after the command name
+};
+
+struct ParallelOptions
+{
+    std::size_t jobs = 0;   ///< max concurrent commands (0 = all at once)
+    bool group = false;     ///< buffer output per command, print it on completion
+    bool fail_fast = false; ///< after the first failure, SIGTERM the rest, start nothing new
+    bool quiet = false;     ///< no per-command status lines
+
+    /// If set, every command beyond the first needs one of its tokens, so
+    /// the run stays inside the shared make/cargo CPU budget.
+    Jobserver* jobserver = nullptr;
+};
+
+/// Outcome of one command.
+struct ParallelResult
+{
+    std::string name;
+    int exit_code = -1; ///< -1 if never started
+    double seconds = 0;
+    bool cancelled = false; ///< stopped or skipped by --fail-fast
+};
+
+namespace detail {
+
+inline constexpr const char* par_colors[] = {
+    style::cyan, style::green, style::yellow, style::blue, style::gray};
+
+inline void status_line(const ParallelResult& r)
+{
+    if (r.cancelled) {
+        std::println(stderr, "{} {} cancelled", style::dim_text("–"), r.name);
+    } else if (r.exit_code == 0) {
+        std::println(stderr, "{} {} ({:.2f}s)", style::green_text("✓"), r.name, r.seconds);
+    } else {
+        std::println(stderr,
+                     "{} {} exited {} ({:.2f}s)",
+                     style::red_text("✗"),
+                     r.name,
+                     r.exit_code,
+                     r.seconds);
+    }
+}
+
+#ifndef _WIN32
+
+inline void write_all(int fd, std::string_view data)
+{
+    while (!data.empty()) {
+        auto n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data.remove_prefix(static_cast<std::size_t>(n));
+    }
+}
+
+/// A started command and its captured streams.
+struct ParallelChild
+{
+    std::size_t index = 0;
+    process_id pid = -1;
+    int fd[2] = {-1, -1};        ///< read ends: [0] stdout, [1] stderr
+    std::string pending[2];      ///< partial line (line mode) / everything (group mode)
+    std::chrono::steady_clock::time_point t0;
+    std::uint64_t trace_t0 = 0;
+};
+
+class ParallelRunner
+{
+public:
+    ParallelRunner(const std::vector<ParallelJob>& jobs, const ParallelOptions& opts)
+        : jobs_(jobs)
+        , opts_(opts)
+        , results_(jobs.size())
+    {
+        std::size_t width = 0;
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            results_[i].name = jobs[i].name;
+            width = std::max(width, jobs[i].name.size());
+        }
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            auto label = jobs[i].name;
+            label.resize(width, ' ');
+            prefixes_.push_back(style::styled(par_colors[i % std::size(par_colors)], label) +
+                                style::dim_text(" | "));
+        }
+        limit_ = opts.jobs ? opts.jobs : std::max<std::size_t>(1, jobs.size());
+    }
+
+    int run()
+    {
+        std::size_t next = 0;
+        while ((!cancel_ && next < jobs_.size()) || !running_.empty()) {
+            want_token_ = false;
+            while (!cancel_ && next < jobs_.size() && running_.size() < limit_) {
+                // The first command runs on dev's implicit slot.
+                if (opts_.jobserver && !running_.empty() && !opts_.jobserver->try_acquire()) {
+                    want_token_ = true;
+                    break;
+                }
+                start(next++);
+            }
+            if (running_.empty()) {
+                continue;
+            }
+            pump();
+            reap();
+        }
+        for (std::size_t i = next; i < jobs_.size(); ++i) {
+            results_[i].cancelled = true;
+            if (!opts_.quiet) {
+                status_line(results_[i]);
+            }
+        }
+        return first_failure_;
+    }
+
+    [[nodiscard]] std::vector<ParallelResult> results() &&
+    {
+        return std::move(results_);
+    }
+
+private:
+    const std::vector<ParallelJob>& jobs_;
+    const ParallelOptions& opts_;
+    std::vector<ParallelResult> results_;
+    std::vector<std::string> prefixes_;
+    std::vector<ParallelChild> running_;
+    std::size_t limit_ = 1;
+    int first_failure_ = 0;
+    bool cancel_ = false;
+    bool want_token_ = false; ///< a command is waiting for a jobserver token
+
+    void start(std::size_t i)
+    {
+        const auto& job = jobs_[i];
+        ParallelChild c;
+        c.index = i;
+        c.t0 = std::chrono::steady_clock::now();
+        c.trace_t0 = trace::now_us();
+
+        int out[2];
+        int err[2];
+        if (!make_pipe(out)) {
+            finish(c, 126);
+            return;
+        }
+        if (!make_pipe(err)) {
+            ::close(out[0]);
+            ::close(out[1]);
+            finish(c, 126);
+            return;
+        }
+
+        std::string exe = job.exe.string();
+        std::vector<const char*> argv;
+        argv.push_back(exe.c_str());
+        for (const auto& a : job.args) {
+            argv.push_back(a.c_str());
+        }
+        argv.push_back(nullptr);
+
+        SpawnOptions so;
+        so.out = out[1];
+        so.err = err[1];
+        c.pid = start_plugin(job.exe, argv.data(), so);
+        ::close(out[1]);
+        ::close(err[1]);
+        c.fd[0] = out[0];
+        c.fd[1] = err[0];
+
+        if (c.pid == -1) {
+            ::close(c.fd[0]);
+            ::close(c.fd[1]);
+            finish(c, 126);
+            return;
+        }
+        running_.push_back(std::move(c));
+    }
+
+    /// Wait for output (or, while a child has closed its pipes but not
+    /// exited yet, for a short tick) and forward what arrived.
+    void pump()
+    {
+        std::vector<pollfd> pfds;
+        std::vector<std::pair<std::size_t, int>> owners; // running_ index, stream
+        bool lingering = false;
+        for (std::size_t r = 0; r < running_.size(); ++r) {
+            bool open = false;
+            for (int s = 0; s < 2; ++s) {
+                if (running_[r].fd[s] >= 0) {
+                    pfds.push_back({running_[r].fd[s], POLLIN, 0});
+                    owners.emplace_back(r, s);
+                    open = true;
+                }
+            }
+            lingering = lingering || !open;
+        }
+        if (pfds.empty() && !lingering) {
+            return;
+        }
+        if (want_token_) {
+            // Wakes us when a token comes back; run() then retries.
+            pfds.push_back({opts_.jobserver->wait_fd(), POLLIN, 0});
+        }
+
+        int n = ::poll(pfds.data(), static_cast<nfds_t>(pfds.size()), lingering ? 10 : -1);
+        if (n <= 0) {
+            return; // timeout or EINTR: reap() runs next
+        }
+
+        char buf[16 * 1024];
+        for (std::size_t k = 0; k < owners.size(); ++k) {
+            if (pfds[k].revents == 0) {
+                continue;
+            }
+            auto [r, s] = owners[k];
+            auto& c = running_[r];
+            auto got = ::read(c.fd[s], buf, sizeof buf);
+            if (got > 0) {
+                c.pending[s].append(buf, static_cast<std::size_t>(got));
+                if (!opts_.group) {
+                    emit_lines(c, s, false);
+                }
+            } else if (got == 0 || errno != EINTR) {
+                ::close(c.fd[s]);
+                c.fd[s] = -1;
+            }
+        }
+    }
+
+    /// Line mode: forward complete lines (at EOF also the unterminated
+    /// tail) in one write.
+    void emit_lines(ParallelChild& c, int s, bool eof)
+    {
+        auto& data = c.pending[s];
+        if (eof && !data.empty() && data.back() != '\n') {
+            data += '\n';
+        }
+        auto end = data.rfind('\n');
+        if (end == std::string::npos) {
+            return;
+        }
+        std::string out;
+        for (std::size_t pos = 0; pos <= end;) {
+            auto nl = data.find('\n', pos);
+            out += prefixes_[c.index];
+            out.append(data, pos, nl + 1 - pos);
+            pos = nl + 1;
+        }
+        data.erase(0, end + 1);
+        write_all(s == 0 ? STDOUT_FILENO : STDERR_FILENO, out);
+    }
+
+    /// Collect children whose pipes are closed and that have exited.
+    void reap()
+    {
+        for (std::size_t r = 0; r < running_.size();) {
+            auto& c = running_[r];
+            if (c.fd[0] >= 0 || c.fd[1] >= 0) {
+                ++r;
+                continue;
+            }
+            int status = 0;
+            auto w = ::waitpid(c.pid, &status, WNOHANG);
+            if (w == 0 || (w < 0 && errno == EINTR)) {
+                ++r;
+                continue;
+            }
+            int code = (w < 0) ? -1 : (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+            auto done = std::move(c);
+            running_.erase(running_.begin() + static_cast<std::ptrdiff_t>(r));
+            finish(done, code);
+        }
+    }
+
+    void finish(ParallelChild& c, int code)
+    {
+        auto& result = results_[c.index];
+        result.exit_code = code;
+        if (opts_.jobserver && opts_.jobserver->held() > 0) {
+            opts_.jobserver->release(); // keeps held == running - 1
+        }
+        result.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - c.t0).count();
+        trace::complete(result.name, c.trace_t0, trace::now_us() - c.trace_t0, "par");
+
+        for (int s = 0; s < 2; ++s) {
+            if (!opts_.group) {
+                emit_lines(c, s, true);
+            } else if (!c.pending[s].empty()) {
+                auto& data = c.pending[s];
+                if (data.back() != '\n') {
+                    data += '\n';
+                }
+                write_all(s == 0 ? STDOUT_FILENO : STDERR_FILENO,
+                          style::bold_text("── " + result.name + " ──") + "\n" + data);
+            }
+        }
+
+        // A cancelled child's own exit is not a failure of the run.
+        bool was_cancelled = cancel_ && code != 0;
+        result.cancelled = was_cancelled;
+        if (!opts_.quiet) {
+            status_line(result);
+        }
+        if (code != 0 && !was_cancelled) {
+            if (first_failure_ == 0) {
+                first_failure_ = code;
+            }
+            if (opts_.fail_fast && !cancel_) {
+                cancel_ = true;
+                for (const auto& other : running_) {
+                    ::kill(other.pid, SIGTERM);
+                }
+            }
+        }
+    }
+};
+
+#endif // !_WIN32
+
+} // namespace detail
+
+/// Run `jobs` with at most `opts.jobs` at a time.
+///
+/// @return  0 if every command succeeded, otherwise the exit code of the
+///          first command to fail (by completion time).
+inline int run_parallel(const std::vector<ParallelJob>& jobs,
+                        const ParallelOptions& opts = {},
+                        std::vector<ParallelResult>* results = nullptr)
+{
+#ifdef _WIN32
+    // No poll() on anonymous pipes: run sequentially, output inherited.
+    int first_failure = 0;
+    std::vector<ParallelResult> out;
+    for (const auto& job : jobs) {
+        ParallelResult r;
+        r.name = job.name;
+        if (first_failure != 0 && opts.fail_fast) {
+            r.cancelled = true;
+        } else {
+            std::vector<char*> argv;
+            std::vector<std::string> storage{job.name};
+            storage.insert(storage.end(), job.args.begin(), job.args.end());
+            for (auto& s : storage) {
+                argv.push_back(s.data());
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            r.exit_code = spawn(job.exe, static_cast<int>(argv.size()), argv.data(), 1);
+            r.seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (r.exit_code != 0 && first_failure == 0) {
+                first_failure = r.exit_code;
+            }
+        }
+        if (!opts.quiet) {
+            detail::status_line(r);
+        }
+        out.push_back(std::move(r));
+    }
+    if (results) {
+        *results = std::move(out);
+    }
+    return first_failure;
+#else
+    // The terminal's SIGINT/SIGQUIT reach the children (same process
+    // group); dev survives them to drain output and report.  A no-op
+    // handler rather than SIG_IGN, which children would inherit.
+    struct sigaction survive{};
+    struct sigaction old_int{};
+    struct sigaction old_quit{};
+    survive.sa_handler = [](int) {};
+    sigemptyset(&survive.sa_mask);
+    ::sigaction(SIGINT, &survive, &old_int);
+    ::sigaction(SIGQUIT, &survive, &old_quit);
+
+    detail::ParallelRunner runner(jobs, opts);
+    int rc = runner.run();
+
+    ::sigaction(SIGINT, &old_int, nullptr);
+    ::sigaction(SIGQUIT, &old_quit, nullptr);
+    if (results) {
+        *results = std::move(runner).results();
+    }
+    return rc;
+#endif
+}
+
+} // namespace dev
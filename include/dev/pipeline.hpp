@@ -0,0 +1,321 @@
+/**
+ * @file pipeline.hpp
+ * @brief Plugin pipelines (`dev pipe a -- b -- c`).
+ *
+ * Stages are started concurrently and connected stdout → stdin with
+ * kernel pipes, so the data never passes through dev.  Stages that declare
+ * raw byte streaming (`stream = "raw"` in plugins.toml) get a larger pipe
+ * buffer (F_SETPIPE_SZ, Linux) to cut context switches.  A tap copies one
+ * boundary's bytes to a file: on Linux with tee() + splice(), so the copy
+ * stays in the kernel as well.
+ */
+
+#pragma once
+
+#include "dev/loader.hpp"
+#include "dev/process.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// One stage of a pipeline.
+struct PipelineStage
+{
+    std::string name;              ///< command name (for errors and traces)
+    fs::path exe;                  ///< resolved plugin executable
+    std::vector<std::string> args; ///< arguments after the command name
+    bool raw = false;              ///< declares raw byte streaming
+};
+
+struct PipelineOptions
+{
+    /// Pipe buffer for the output of raw stages (0 = kernel default).
+    std::size_t raw_pipe_size = std::size_t{1} << 20;
+
+    /// Copy the output of stage `tap_stage` (0-based) to `tap_file`.
+    /// -1 = no tap.  Not applicable to the last stage.
+    int tap_stage = -1;
+    fs::path tap_file;
+};
+
+namespace detail {
+
+#ifndef _WIN32
+
+/// Exit status the way a shell reports it: code, or 128 + signal.
+inline int shell_status(int status)
+{
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return 1;
+}
+
+inline void grow_pipe([[maybe_unused]] int fd, [[maybe_unused]] std::size_t size)
+{
+#ifdef F_SETPIPE_SZ
+    if (size > 0) {
+        // Capped by /proc/sys/fs/pipe-max-size; failure keeps the default.
+        ::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(size));
+    }
+#endif
+}
+
+/// Write all `n` bytes of `data` to `fd`.  False if it fails.
+inline bool write_all(int fd, const char* data, std::size_t n)
+{
+    while (n > 0) {
+        auto m = ::write(fd, data, n);
+        if (m < 0 && errno == EINTR) {
+            continue;
+        }
+        if (m <= 0) {
+            return false;
+        }
+        data += m;
+        n -= static_cast<std::size_t>(m);
+    }
+    return true;
+}
+
+/// Forward everything from pipe `in` to pipe `out`, copying it to `file`.
+/// Linux: tee() duplicates pipe pages, splice() moves them to the file —
+/// no byte is copied through user space.  Elsewhere, and once the file
+/// refuses splice(): read + two writes.  Only a gone reader ends the copy
+/// early; a file that stops taking writes just stops being copied to.
+inline void tap_copy(int in, int out, int file)
+{
+    char buf[64 * 1024];
+#ifdef __linux__
+    for (bool spliced = true; spliced;) {
+        auto n = ::tee(in, out, std::size_t{1} << 20, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EINVAL) {
+            break; // not pipes after all: use the portable loop below
+        }
+        if (n <= 0) {
+            return; // EOF, or the reader is gone (EPIPE)
+        }
+        // tee() left the data in `in`; move exactly n bytes to the file.
+        for (auto left = static_cast<std::size_t>(n); left > 0;) {
+            auto m = ::splice(in, nullptr, file, nullptr, left, SPLICE_F_MOVE);
+            if (m < 0 && errno == EINTR) {
+                continue;
+            }
+            if (m > 0) {
+                left -= static_cast<std::size_t>(m);
+                continue;
+            }
+            // The file takes no splice() (O_APPEND, a tty, a filesystem
+            // without support): the bytes tee() already passed on are
+            // still in `in`, so copy them by hand and stay with read +
+            // write from here on.
+            while (left > 0) {
+                auto r = ::read(in, buf, std::min(left, sizeof buf));
+                if (r < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (r <= 0) {
+                    break;
+                }
+                if (file >= 0 && !write_all(file, buf, static_cast<std::size_t>(r))) {
+                    file = -1;
+                }
+                left -= static_cast<std::size_t>(r);
+            }
+            spliced = false;
+            break;
+        }
+    }
+#endif
+    for (;;) {
+        auto n = ::read(in, buf, sizeof buf);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        if (!write_all(out, buf, static_cast<std::size_t>(n))) {
+            return;
+        }
+        if (file >= 0 && !write_all(file, buf, static_cast<std::size_t>(n))) {
+            file = -1;
+        }
+    }
+}
+
+#endif // !_WIN32
+
+} // namespace detail
+
+/// Run `stages` as one pipeline and wait for all of them.
+///
+/// @param statuses  If non-null, receives every stage's shell-style status.
+/// @return          pipefail status: the rightmost non-zero stage status,
+///                  0 if all succeeded, 126 if a stage could not start.
+inline int run_pipeline(const std::vector<PipelineStage>& stages,
+                        const PipelineOptions& opts = {},
+                        std::vector<int>* statuses = nullptr)
+{
+#ifdef _WIN32
+    (void)stages;
+    (void)opts;
+    (void)statuses;
+    return 126; // not implemented: no inheritable-pipe plumbing in start()
+#else
+    const auto n = stages.size();
+    std::vector<process_id> pids(n, -1);
+    std::vector<int> result(n, 126);
+
+    int tap_file = -1;
+    if (opts.tap_stage >= 0 && static_cast<std::size_t>(opts.tap_stage) + 1 < n) {
+        tap_file = ::open(opts.tap_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (tap_file < 0) {
+            return 126;
+        }
+    }
+
+    // The terminal's SIGINT reaches every stage; dev survives it (and
+    // SIGPIPE while tapping) to reap them.  No-op handlers, not SIG_IGN,
+    // which the stages would inherit.
+    struct sigaction survive{};
+    struct sigaction old_int{};
+    struct sigaction old_pipe{};
+    survive.sa_handler = [](int) {};
+    sigemptyset(&survive.sa_mask);
+    ::sigaction(SIGINT, &survive, &old_int);
+    ::sigaction(SIGPIPE, &survive, &old_pipe);
+
+    int tap_in = -1;  // tapped stage's stdout, read by dev
+    int tap_out = -1; // next stage's stdin, written by dev
+    int prev_read = -1;
+    bool failed_to_start = false;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& st = stages[i];
+        int link[2] = {-1, -1};
+        if (i + 1 < n) {
+            if (!make_pipe(link)) {
+                failed_to_start = true;
+                break;
+            }
+            if (st.raw) {
+                detail::grow_pipe(link[1], opts.raw_pipe_size);
+            }
+        }
+
+        // With a tap after this stage, dev sits between two pipes.
+        int next_read = link[0];
+        if (tap_file >= 0 && static_cast<int>(i) == opts.tap_stage) {
+            int second[2];
+            if (!make_pipe(second)) {
+                ::close(link[0]);
+                ::close(link[1]);
+                failed_to_start = true;
+                break;
+            }
+            if (st.raw) {
+                detail::grow_pipe(second[1], opts.raw_pipe_size);
+            }
+            tap_in = link[0];
+            tap_out = second[1];
+            next_read = second[0];
+        }
+
+        std::string exe = st.exe.string();
+        std::vector<const char*> argv;
+        argv.push_back(exe.c_str());
+        for (const auto& a : st.args) {
+            argv.push_back(a.c_str());
+        }
+        argv.push_back(nullptr);
+
+        SpawnOptions so;
+        so.in = prev_read;
+        so.out = link[1];
+        {
+            trace::Span span("spawn", st.name);
+            pids[i] = start_plugin(st.exe, argv.data(), so);
+        }
+
+        if (prev_read >= 0) {
+            ::close(prev_read);
+        }
+        if (link[1] >= 0) {
+            ::close(link[1]);
+        }
+        prev_read = next_read;
+
+        if (pids[i] == -1) {
+            failed_to_start = true;
+            break;
+        }
+    }
+    if (prev_read >= 0) {
+        ::close(prev_read);
+    }
+
+    if (tap_in >= 0) {
+        if (!failed_to_start) {
+            trace::Span span("tap", opts.tap_file.string());
+            detail::tap_copy(tap_in, tap_out, tap_file);
+        }
+        ::close(tap_in);
+        ::close(tap_out);
+    }
+    if (tap_file >= 0) {
+        ::close(tap_file);
+    }
+
+    {
+        trace::Span span("wait", "pipeline");
+        for (std::size_t i = 0; i < n; ++i) {
+            if (pids[i] == -1) {
+                continue;
+            }
+            int status = 0;
+            while (::waitpid(pids[i], &status, 0) < 0 && errno == EINTR) {
+            }
+            result[i] = detail::shell_status(status);
+        }
+    }
+
+    ::sigaction(SIGINT, &old_int, nullptr);
+    ::sigaction(SIGPIPE, &old_pipe, nullptr);
+
+    int rc = 0;
+    for (auto code : result) {
+        if (code != 0) {
+            rc = code; // rightmost failure wins, as with `set -o pipefail`
+        }
+    }
+    if (statuses) {
+        *statuses = std::move(result);
+    }
+    return rc;
+#endif
+}
+
+} // namespace dev
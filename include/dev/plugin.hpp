@@ -0,0 +1,166 @@
+/**
+ * @file plugin.hpp
+ * @brief Plugin SDK — versioned C ABI for in-process (shared-library) plugins.
+ *
+ * A shared-library plugin is `<name>.so` (`.dylib` on macOS, `.dll` on
+ * Windows) in a plugin dir, exporting one C symbol:
+ *
+ *     const dev_plugin_info_v1* dev_plugin_v1(void);
+ *
+ * dev loads it with dlopen() and calls `run` directly — no fork, exec or
+ * dynamic-loader startup.  The usual way to write one is a normal
+ * `main`-style function plus DEV_PLUGIN_MAIN, which builds the same source
+ * as an executable, as a shared plugin (DEV_PLUGIN_SHARED) or into dev
+ * itself (DEV_PLUGIN_BUILTIN, see dev/multicall.hpp):
+ *
+ *     static int hello_main(int argc, char* argv[]) { ... }
+ *     DEV_PLUGIN_MAIN(hello_main, "hello", "Greet someone", "1.0.0")
+ *
+ * Any plugin — executable or shared — can also describe itself without
+ * being run: DEV_PLUGIN_META embeds name, description, version, flags and
+ * completion words in an ELF note that dev reads straight from the file
+ * (see dev/plugin_meta.hpp):
+ *
+ *     DEV_PLUGIN_META("hello", "Greet someone", "1.0.0", "", "--loud --name")
+ *
+ * The declarations are plain C, so plugins may be written in C as well.
+ * Breaking changes get a new entry point (`dev_plugin_v2`); v1 stays.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEV_PLUGIN_ABI_VERSION 1
+#define DEV_PLUGIN_ENTRY_V1 "dev_plugin_v1"
+
+/// Standard streams of the invocation.  In-process they are 0/1/2; always
+/// use these (or stdio) rather than assuming a terminal.
+typedef struct dev_plugin_io
+{
+    int in;
+    int out;
+    int err;
+} dev_plugin_io;
+
+/// Plugin body: argv[0] is the plugin path, argv[1..] the user's arguments,
+/// envp the environment.  Returns the exit code.
+typedef int (*dev_plugin_run_fn)(int argc, char** argv, char** envp, const dev_plugin_io* io);
+
+typedef struct dev_plugin_info_v1
+{
+    uint32_t abi_version;    ///< DEV_PLUGIN_ABI_VERSION
+    uint32_t size;           ///< sizeof(dev_plugin_info_v1), for appending fields
+    const char* name;        ///< command name
+    const char* description; ///< one line for `dev list` (plugins.toml wins)
+    const char* version;     ///< plugin version, may be NULL
+    dev_plugin_run_fn run;
+} dev_plugin_info_v1;
+
+typedef const dev_plugin_info_v1* (*dev_plugin_entry_v1)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef _WIN32
+#define DEV_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define DEV_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+#define DEV_PLUGIN_EXTERN_C extern "C"
+#else
+#define DEV_PLUGIN_EXTERN_C
+#endif
+
+/// Define the v1 entry point for `info` (a dev_plugin_info_v1 object).
+#define DEV_PLUGIN_DEFINE(info)                                                                    \
+    DEV_PLUGIN_EXTERN_C DEV_PLUGIN_EXPORT const dev_plugin_info_v1* dev_plugin_v1(void)           \
+    {                                                                                              \
+        return &(info);                                                                            \
+    }
+
+// ── Embedded metadata ───────────────────────────────────────
+
+/// ELF note carrying DEV_PLUGIN_META: owner "dev", this type, and a
+/// descriptor of five NUL-terminated strings — name, description, version,
+/// flags, completion — in that order.  New fields are appended.
+#define DEV_PLUGIN_NOTE_SECTION ".note.dev.plugin"
+#define DEV_PLUGIN_NOTE_OWNER "dev"
+#define DEV_PLUGIN_NOTE_TYPE 1
+
+/// Embed plugin metadata in the binary.  All arguments are string
+/// literals; `flags` and `completion` are space-separated words:
+///   - flags:       `raw` — byte stream, `dev pipe` gives it a larger pipe
+///   - completion:  options and subcommands offered by shell completion
+/// Use once per plugin, at file scope.  Expands to nothing on non-ELF
+/// targets (macOS, Windows), where plugins.toml remains the only source,
+/// and for DEV_PLUGIN_BUILTIN, whose info struct lives in dev itself.
+#if defined(__ELF__) && !defined(DEV_PLUGIN_BUILTIN)
+#define DEV_PLUGIN_META(name, description, version, flags, completion)                             \
+    DEV_PLUGIN_NOTE_(name "\0" description "\0" version "\0" flags "\0" completion)
+#define DEV_PLUGIN_NOTE_(desc)                                                                     \
+    __attribute__((used, section(DEV_PLUGIN_NOTE_SECTION), aligned(4))) static const struct       \
+    {                                                                                              \
+        uint32_t namesz;                                                                           \
+        uint32_t descsz;                                                                           \
+        uint32_t type;                                                                             \
+        char owner[4];                                                                             \
+        char data[(sizeof(desc) + 3) / 4 * 4];                                                     \
+    } dev_plugin_note_ = {                                                                         \
+        sizeof(DEV_PLUGIN_NOTE_OWNER),                                                             \
+        sizeof(desc),                                                                              \
+        DEV_PLUGIN_NOTE_TYPE,                                                                      \
+        DEV_PLUGIN_NOTE_OWNER,                                                                     \
+        desc,                                                                                      \
+    };
+#else
+#define DEV_PLUGIN_META(name, description, version, flags, completion)
+#endif
+
+/// Turn `int fn(int argc, char* argv[])` into the program's entry point:
+///   - default:             `main`, for an executable plugin
+///   - DEV_PLUGIN_SHARED:   the exported `dev_plugin_v1`, for a shared plugin
+///   - DEV_PLUGIN_BUILTIN:  the same entry under that name, for a plugin
+///                          compiled into dev itself (DEV_MULTICALL)
+#if defined(DEV_PLUGIN_BUILTIN)
+#define DEV_PLUGIN_ENTRY_DECL_                                                                     \
+    DEV_PLUGIN_EXTERN_C const dev_plugin_info_v1* DEV_PLUGIN_BUILTIN(void)
+#elif defined(DEV_PLUGIN_SHARED)
+#define DEV_PLUGIN_ENTRY_DECL_                                                                     \
+    DEV_PLUGIN_EXTERN_C DEV_PLUGIN_EXPORT const dev_plugin_info_v1* dev_plugin_v1(void)
+#endif
+
+#ifdef DEV_PLUGIN_ENTRY_DECL_
+#define DEV_PLUGIN_MAIN(fn, name, description, version)                                            \
+    static int dev_plugin_run_(int argc, char** argv, char** envp, const dev_plugin_io* io)       \
+    {                                                                                              \
+        (void)envp;                                                                                \
+        (void)io;                                                                                  \
+        return fn(argc, argv);                                                                     \
+    }                                                                                              \
+    static const dev_plugin_info_v1 dev_plugin_info_ = {                                           \
+        DEV_PLUGIN_ABI_VERSION,                                                                    \
+        sizeof(dev_plugin_info_v1),                                                                \
+        name,                                                                                      \
+        description,                                                                               \
+        version,                                                                                   \
+        dev_plugin_run_,                                                                           \
+    };                                                                                             \
+    DEV_PLUGIN_ENTRY_DECL_                                                                         \
+    {                                                                                              \
+        return &dev_plugin_info_;                                                                  \
+    }
+#else
+#define DEV_PLUGIN_MAIN(fn, name, description, version)                                            \
+    int main(int argc, char* argv[])                                                               \
+    {                                                                                              \
+        return fn(argc, argv);                                                                     \
+    }
+#endif
@@ -0,0 +1,237 @@
+/**
+ * @file plugin_meta.hpp
+ * @brief Read DEV_PLUGIN_META from a plugin binary without running it.
+ *
+ * The metadata is an ELF note (see dev/plugin.hpp), so finding it is
+ * header parsing: map the file, walk the PT_NOTE program headers — they
+ * sit in the first page — and match owner "dev".  Files whose notes are
+ * not covered by a segment fall back to the SHT_NOTE section headers.
+ * Nothing is loaded or executed, and scripts or foreign binaries are
+ * rejected after the first few bytes.
+ *
+ * Only images of the host's byte order are read; plugins are native
+ * binaries anyway.
+ */
+
+#pragma once
+
+#include "dev/mmap.hpp"
+#include "dev/plugin.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// What a plugin says about itself.  Empty fields were not given.
+struct PluginMeta
+{
+    std::string name;
+    std::string description;
+    std::string version;
+    std::string flags;      ///< space-separated, e.g. "raw"
+    std::string completion; ///< space-separated completion words
+
+    /// Whether `flag` is one of the words in `flags`.
+    [[nodiscard]] bool has_flag(std::string_view flag) const
+    {
+        std::string_view rest = flags;
+        while (!rest.empty()) {
+            auto end = rest.find(' ');
+            if (rest.substr(0, end) == flag) {
+                return true;
+            }
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+        }
+        return false;
+    }
+};
+
+namespace detail {
+
+/// Bounds-checked reads from an ELF image of either class.
+class ElfReader
+{
+public:
+    explicit ElfReader(std::string_view image)
+        : image_(image)
+    {
+    }
+
+    /// Check the identification bytes; false if not a native ELF file.
+    bool identify()
+    {
+        constexpr unsigned char native = std::endian::native == std::endian::little ? 1 : 2;
+        if (image_.size() < 16 || std::memcmp(image_.data(), "\x7f" "ELF", 4) != 0 ||
+            static_cast<unsigned char>(image_[5]) != native) {
+            return false;
+        }
+        wide_ = image_[4] == 2; // ELFCLASS64
+        return image_[4] == 1 || wide_;
+    }
+
+    [[nodiscard]] bool wide() const
+    {
+        return wide_;
+    }
+
+    /// Unsigned field of `size` bytes at `off`; `ok` is cleared when out
+    /// of bounds.
+    std::uint64_t field(std::uint64_t off, std::size_t size, bool& ok) const
+    {
+        if (off > image_.size() || image_.size() - off < size) {
+            ok = false;
+            return 0;
+        }
+        if (size == 2) {
+            std::uint16_t v;
+            std::memcpy(&v, image_.data() + off, sizeof v);
+            return v;
+        }
+        if (size == 4) {
+            std::uint32_t v;
+            std::memcpy(&v, image_.data() + off, sizeof v);
+            return v;
+        }
+        std::uint64_t v;
+        std::memcpy(&v, image_.data() + off, sizeof v);
+        return v;
+    }
+
+    /// Address-sized field: 4 bytes in ELF32, 8 in ELF64.
+    std::uint64_t word(std::uint64_t off, bool& ok) const
+    {
+        return field(off, wide_ ? 8 : 4, ok);
+    }
+
+    [[nodiscard]] std::string_view bytes(std::uint64_t off, std::uint64_t size) const
+    {
+        if (off > image_.size() || image_.size() - off < size) {
+            return {};
+        }
+        return image_.substr(static_cast<std::size_t>(off), static_cast<std::size_t>(size));
+    }
+
+private:
+    std::string_view image_;
+    bool wide_ = false;
+};
+
+/// Find the dev note among the notes in `notes`, aligned to `align`.
+inline std::optional<std::string_view> find_dev_note(std::string_view notes, std::uint64_t align)
+{
+    align = align == 8 ? 8 : 4;
+    auto pad = [&](std::uint64_t n) { return (n + align - 1) / align * align; };
+    constexpr std::string_view owner{DEV_PLUGIN_NOTE_OWNER, sizeof(DEV_PLUGIN_NOTE_OWNER)};
+
+    while (notes.size() >= 12) {
+        std::uint32_t namesz;
+        std::uint32_t descsz;
+        std::uint32_t type;
+        std::memcpy(&namesz, notes.data(), 4);
+        std::memcpy(&descsz, notes.data() + 4, 4);
+        std::memcpy(&type, notes.data() + 8, 4);
+        std::uint64_t name_end = 12 + pad(namesz);
+        std::uint64_t desc_end = name_end + pad(descsz);
+        if (name_end > notes.size() || name_end + descsz > notes.size()) {
+            return std::nullopt;
+        }
+        if (type == DEV_PLUGIN_NOTE_TYPE && notes.substr(12, namesz) == owner) {
+            return notes.substr(static_cast<std::size_t>(name_end), descsz);
+        }
+        if (desc_end >= notes.size()) {
+            break;
+        }
+        notes.remove_prefix(static_cast<std::size_t>(desc_end));
+    }
+    return std::nullopt;
+}
+
+/// The dev note's descriptor in an ELF image, if any.
+inline std::optional<std::string_view> dev_note(std::string_view image)
+{
+    ElfReader elf(image);
+    if (!elf.identify()) {
+        return std::nullopt;
+    }
+    bool ok = true;
+    const bool w = elf.wide();
+
+    // Program headers: PT_NOTE (4) segments.
+    auto phoff = elf.word(w ? 32 : 28, ok);
+    auto phentsize = elf.field(w ? 54 : 42, 2, ok);
+    auto phnum = elf.field(w ? 56 : 44, 2, ok);
+    for (std::uint64_t i = 0; ok && i < phnum; ++i) {
+        auto ph = phoff + i * phentsize;
+        if (elf.field(ph, 4, ok) != 4) {
+            continue;
+        }
+        auto offset = elf.word(ph + (w ? 8 : 4), ok);
+        auto filesz = elf.word(ph + (w ? 32 : 16), ok);
+        auto align = elf.word(ph + (w ? 48 : 28), ok);
+        if (auto note = find_dev_note(elf.bytes(offset, filesz), align); ok && note) {
+            return note;
+        }
+    }
+
+    // Section headers: SHT_NOTE (7) sections, e.g. in object files.
+    ok = true;
+    auto shoff = elf.word(w ? 40 : 32, ok);
+    auto shentsize = elf.field(w ? 58 : 46, 2, ok);
+    auto shnum = elf.field(w ? 60 : 48, 2, ok);
+    for (std::uint64_t i = 0; ok && shoff != 0 && i < shnum; ++i) {
+        auto sh = shoff + i * shentsize;
+        if (elf.field(sh + 4, 4, ok) != 7) {
+            continue;
+        }
+        auto offset = elf.word(sh + (w ? 24 : 16), ok);
+        auto size = elf.word(sh + (w ? 32 : 20), ok);
+        auto align = elf.word(sh + (w ? 48 : 32), ok);
+        if (auto note = find_dev_note(elf.bytes(offset, size), align); ok && note) {
+            return note;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace detail
+
+/// Parse DEV_PLUGIN_META out of an ELF image in memory.
+inline std::optional<PluginMeta> parse_plugin_meta(std::string_view image)
+{
+    auto desc = detail::dev_note(image);
+    if (!desc) {
+        return std::nullopt;
+    }
+    PluginMeta meta;
+    std::string* fields[] = {
+        &meta.name, &meta.description, &meta.version, &meta.flags, &meta.completion};
+    std::string_view rest = *desc;
+    for (auto* f : fields) {
+        auto end = rest.find('\0');
+        if (end == std::string_view::npos) {
+            break; // truncated: keep what is complete
+        }
+        f->assign(rest.substr(0, end));
+        rest.remove_prefix(end + 1);
+    }
+    return meta;
+}
+
+/// Read DEV_PLUGIN_META from a plugin file without executing or loading
+/// it.  nullopt for scripts, non-ELF binaries and plugins without it.
+inline std::optional<PluginMeta> read_plugin_meta(const fs::path& path)
+{
+    auto file = MappedFile::open(path);
+    return parse_plugin_meta(file.view());
+}
+
+} // namespace dev
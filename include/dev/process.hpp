@@ -1,66 +1,520 @@
 /**
  * @file process.hpp
  * @brief Cross-platform process spawning (replaces std::system).
+ *
+ * POSIX children can be created through several backends (fork, a
+ * vfork-style clone, posix_spawn) behind one start()/wait_for() API so that
+ * fork-heavy workloads can be benchmarked and tuned at runtime.
  */
 
 #pragma once
 
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
 #include <process.h>
+#include <system_error>
+#include <windows.h>
+#include <psapi.h>
 #else
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifndef _WIN32
+extern char** environ; // NOLINT
+#endif
+
+#if !defined(_WIN32) && \
+    ((defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 29)) || defined(__APPLE__))
+#define DEV_HAVE_SPAWN_CHDIR 1 // posix_spawn_file_actions_addchdir_np
 #endif
 
 namespace dev {
 
-/// Spawn an executable, wait for it to finish, and return its exit code.
-///
-/// @param executable  Full path to the child executable.
-/// @param argc        Original argc from main().
-/// @param argv        Original argv from main().
-/// @param arg_offset  Index of the first argument to forward (default: 2,
-///                    which skips argv[0]="dev" and argv[1]="<command>").
-/// @return            Child exit code, or -1 on spawn failure.
-inline int
-spawn(const std::filesystem::path& executable, int argc, char* argv[], int arg_offset = 2)
+// ── Backends ────────────────────────────────────────────────
+
+/// How a child process is created.  Ignored on Windows (_spawnv).
+enum class SpawnBackend
 {
+    Fork,       ///< fork() + execv() — copies the parent's page tables
+    Vfork,      ///< clone(CLONE_VM | CLONE_VFORK) + execv() — shares memory until exec
+    PosixSpawn, ///< posix_spawn() — libc picks the cheapest mechanism
+};
 
-    std::string exe_str = executable.string();
+/// Backend used when none is passed explicitly.
+/// Override via `DEV_SPAWN_BACKEND` or `[process] backend` (see main).
+inline SpawnBackend g_spawn_backend = SpawnBackend::PosixSpawn;
 
-    // Build the child argv: { exe, forwarded args..., nullptr }
-    std::vector<const char*> child_argv;
-    child_argv.reserve(static_cast<size_t>(argc - arg_offset) + 2);
-    child_argv.push_back(exe_str.c_str());
-    for (int i = arg_offset; i < argc; ++i) {
-        child_argv.push_back(argv[i]);
+/// Parse a backend name: "fork", "vfork" / "clone", "posix_spawn".
+inline std::optional<SpawnBackend> parse_spawn_backend(std::string_view name)
+{
+    if (name == "fork")
+        return SpawnBackend::Fork;
+    if (name == "vfork" || name == "clone")
+        return SpawnBackend::Vfork;
+    if (name == "posix_spawn" || name == "spawn")
+        return SpawnBackend::PosixSpawn;
+    return std::nullopt;
+}
+
+/// Human-readable backend name (inverse of parse_spawn_backend).
+inline const char* spawn_backend_name(SpawnBackend backend)
+{
+    switch (backend) {
+        case SpawnBackend::Fork:
+            return "fork";
+        case SpawnBackend::Vfork:
+            return "vfork";
+        case SpawnBackend::PosixSpawn:
+            return "posix_spawn";
     }
-    child_argv.push_back(nullptr);
+    return "???";
+}
+
+#ifdef _WIN32
+using process_id = std::intptr_t;
+#else
+using process_id = pid_t;
+#endif
+
+/// Child-side setup applied between creation and exec.
+/// -1 / nullptr means "inherit from the parent".
+struct SpawnOptions
+{
+    int in = -1;                  ///< becomes the child's stdin
+    int out = -1;                 ///< becomes the child's stdout
+    int err = -1;                 ///< becomes the child's stderr
+    const char* cwd = nullptr;    ///< working directory
+    char* const* envp = nullptr;  ///< environment (default: current)
+};
+
+/// Resources consumed by a finished child, as reported by wait4()
+/// (GetProcessTimes / GetProcessMemoryInfo on Windows).
+struct ResourceUsage
+{
+    double wall_s = 0;             ///< start → exit, measured by the parent
+    double user_s = 0;
+    double sys_s = 0;
+    long max_rss_kb = 0;           ///< peak resident set size
+    long major_faults = 0;         ///< page faults that needed I/O
+    long minor_faults = 0;
+    long voluntary_switches = 0;   ///< blocked (typically I/O or locks)
+    long involuntary_switches = 0; ///< preempted (typically CPU-bound)
+};
+
+namespace detail {
 
+#ifndef _WIN32
+/// Runs in the child: apply SpawnOptions and exec.  Only async-signal-safe
+/// calls, so it is valid after fork() and on a CLONE_VM stack.
+[[noreturn]] inline void child_exec(const char* exe, char* const* argv, const SpawnOptions& o)
+{
+    if (o.in >= 0)
+        dup2(o.in, STDIN_FILENO);
+    if (o.out >= 0)
+        dup2(o.out, STDOUT_FILENO);
+    if (o.err >= 0)
+        dup2(o.err, STDERR_FILENO);
+    if (o.cwd && chdir(o.cwd) != 0)
+        _exit(126);
+    execve(exe, argv, o.envp ? o.envp : environ);
+    _exit(126); // execve only returns on failure
+}
+#endif
+
+#if !defined(_WIN32) && defined(__linux__)
+struct CloneArgs
+{
+    const char* exe;
+    char* const* argv;
+    const SpawnOptions* opts;
+    const sigset_t* mask;
+};
+
+/// Entry point of a CLONE_VM child: runs on its own stack, shares memory
+/// with the (suspended) parent, so it must only exec or _exit.
+inline int clone_exec(void* p)
+{
+    auto* a = static_cast<CloneArgs*>(p);
+    sigprocmask(SIG_SETMASK, a->mask, nullptr);
+    child_exec(a->exe, a->argv, *a->opts);
+}
+#endif
+
+} // namespace detail
+
+// ── Start / wait ────────────────────────────────────────────
+
+/// Start an executable without waiting for it.
+///
+/// @param exe      Path to the child executable.
+/// @param argv     nullptr-terminated argument vector (argv[0] = exe).
+/// @param opts     Redirections, working directory, environment.
+/// @param backend  Creation mechanism (POSIX only).
+/// @return         Child id, or -1 on failure (errno is set).
+inline process_id start(const char* exe,
+                        const char* const* argv,
+                        const SpawnOptions& opts = {},
+                        SpawnBackend backend = g_spawn_backend)
+{
 #ifdef _WIN32
-    // _spawnv blocks until child exits and returns its exit code directly.
-    auto rc = _spawnv(_P_WAIT, exe_str.c_str(), const_cast<char* const*>(child_argv.data()));
-    return (rc == -1) ? -1 : static_cast<int>(rc);
+    (void)backend;
+    // _spawnve has no redirection or cwd parameters: swap the parent's
+    // std handles / cwd around the call (dev is single-threaded here).
+    int saved[3] = {-1, -1, -1};
+    const int wanted[3] = {opts.in, opts.out, opts.err};
+    for (int fd = 0; fd < 3; ++fd) {
+        if (wanted[fd] >= 0) {
+            saved[fd] = _dup(fd);
+            _dup2(wanted[fd], fd);
+        }
+    }
+    std::error_code ec;
+    auto old_cwd = std::filesystem::current_path(ec);
+    if (opts.cwd) {
+        std::filesystem::current_path(opts.cwd, ec);
+    }
+
+    auto pid = opts.envp ? _spawnve(_P_NOWAIT, exe, argv, opts.envp) : _spawnv(_P_NOWAIT, exe, argv);
+
+    if (opts.cwd) {
+        std::filesystem::current_path(old_cwd, ec);
+    }
+    for (int fd = 0; fd < 3; ++fd) {
+        if (saved[fd] >= 0) {
+            _dup2(saved[fd], fd);
+            _close(saved[fd]);
+        }
+    }
+    return pid;
+#else
+    auto* child_argv = const_cast<char* const*>(argv);
+
+    switch (backend) {
+        case SpawnBackend::PosixSpawn: {
+#ifndef DEV_HAVE_SPAWN_CHDIR
+            if (opts.cwd) {
+                break; // no portable chdir file action — use fork
+            }
+#endif
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            if (opts.in >= 0)
+                posix_spawn_file_actions_adddup2(&actions, opts.in, STDIN_FILENO);
+            if (opts.out >= 0)
+                posix_spawn_file_actions_adddup2(&actions, opts.out, STDOUT_FILENO);
+            if (opts.err >= 0)
+                posix_spawn_file_actions_adddup2(&actions, opts.err, STDERR_FILENO);
+#ifdef DEV_HAVE_SPAWN_CHDIR
+            if (opts.cwd)
+                posix_spawn_file_actions_addchdir_np(&actions, opts.cwd);
+#endif
+
+            pid_t pid = -1;
+            int rc = posix_spawn(
+                &pid, exe, &actions, nullptr, child_argv, opts.envp ? opts.envp : environ);
+            posix_spawn_file_actions_destroy(&actions);
+            if (rc != 0) {
+                errno = rc;
+                return -1;
+            }
+            return pid;
+        }
+
+        case SpawnBackend::Vfork: {
+#ifdef __linux__
+            // Block signals so no parent handler runs on the shared address
+            // space; the child restores the original mask before exec.
+            sigset_t all;
+            sigset_t old;
+            sigfillset(&all);
+            sigprocmask(SIG_SETMASK, &all, &old);
+
+            alignas(16) char stack[64 * 1024];
+            detail::CloneArgs args{exe, child_argv, &opts, &old};
+            pid_t pid = clone(detail::clone_exec,
+                              stack + sizeof(stack),
+                              CLONE_VM | CLONE_VFORK | SIGCHLD,
+                              &args);
+
+            int saved = errno;
+            sigprocmask(SIG_SETMASK, &old, nullptr);
+            errno = saved;
+            return pid;
 #else
+            // No portable CLONE_VFORK elsewhere (vfork() is deprecated on
+            // macOS); fall through to plain fork.
+            [[fallthrough]];
+#endif
+        }
+
+        case SpawnBackend::Fork:
+            break;
+    }
+
     pid_t pid = fork();
     if (pid == 0) {
         // Child — replace with plugin executable.
-        execv(exe_str.c_str(), const_cast<char**>(child_argv.data()));
-        _exit(126); // execv only returns on failure
+        detail::child_exec(exe, child_argv, opts);
     }
-    if (pid < 0) {
-        return -1; // fork failed
+    return pid;
+#endif
+}
+
+/// Wait for a started child and return its exit code (1 if it was killed).
+/// If `usage` is given, it receives the child's CPU, memory and scheduling
+/// counters (everything but wall_s, which only the caller can measure).
+inline int wait_for(process_id pid, ResourceUsage* usage = nullptr)
+{
+#ifdef _WIN32
+    // _spawn* returns the process handle as the id.  Wait on it directly
+    // rather than with _cwait(), which closes the handle before the
+    // counters below could be read from it.
+    auto handle = reinterpret_cast<HANDLE>(pid);
+    DWORD code = 0;
+    if (WaitForSingleObject(handle, INFINITE) != WAIT_OBJECT_0 ||
+        !GetExitCodeProcess(handle, &code)) {
+        return -1;
+    }
+    if (usage) {
+        FILETIME created, exited, kernel, user;
+        if (GetProcessTimes(handle, &created, &exited, &kernel, &user)) {
+            auto seconds = [](const FILETIME& ft) {
+                ULARGE_INTEGER v;
+                v.LowPart = ft.dwLowDateTime;
+                v.HighPart = ft.dwHighDateTime;
+                return static_cast<double>(v.QuadPart) / 1e7; // 100 ns ticks
+            };
+            usage->user_s = seconds(user);
+            usage->sys_s = seconds(kernel);
+        }
+        PROCESS_MEMORY_COUNTERS mem{};
+        if (GetProcessMemoryInfo(handle, &mem, sizeof mem)) {
+            usage->max_rss_kb = static_cast<long>(mem.PeakWorkingSetSize / 1024);
+            usage->minor_faults = static_cast<long>(mem.PageFaultCount);
+        }
     }
-    // Parent — wait for child.
+    CloseHandle(handle);
+    return static_cast<int>(code);
+#else
     int status = 0;
-    waitpid(pid, &status, 0);
+    struct rusage ru{};
+    while (wait4(pid, &status, 0, &ru) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    if (usage) {
+        auto seconds = [](const timeval& tv) {
+            return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+        };
+        usage->user_s = seconds(ru.ru_utime);
+        usage->sys_s = seconds(ru.ru_stime);
+#ifdef __APPLE__
+        usage->max_rss_kb = ru.ru_maxrss / 1024; // bytes on macOS
+#else
+        usage->max_rss_kb = ru.ru_maxrss;
+#endif
+        usage->major_faults = ru.ru_majflt;
+        usage->minor_faults = ru.ru_minflt;
+        usage->voluntary_switches = ru.ru_nvcsw;
+        usage->involuntary_switches = ru.ru_nivcsw;
+    }
     return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
 #endif
 }
 
+/// Like wait_for(), but give up at `deadline`: std::nullopt if the child
+/// is still running then (it is not reaped and keeps running).
+inline std::optional<int> wait_until(process_id pid,
+                                     std::chrono::steady_clock::time_point deadline,
+                                     ResourceUsage* usage = nullptr)
+{
+    auto remaining_ms = [&] {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        return static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+    };
+#ifdef _WIN32
+    auto handle = reinterpret_cast<HANDLE>(pid);
+    if (WaitForSingleObject(handle, static_cast<DWORD>(remaining_ms())) != WAIT_OBJECT_0) {
+        return std::nullopt;
+    }
+    return wait_for(pid, usage);
+#else
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // A pidfd becomes readable on exit: one poll(), no busy loop.
+    if (int pidfd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0)); pidfd >= 0) {
+        pollfd p{pidfd, POLLIN, 0};
+        int n = 0;
+        while ((n = ::poll(&p, 1, remaining_ms())) < 0 && errno == EINTR) {
+        }
+        ::close(pidfd);
+        return n > 0 ? std::optional<int>(wait_for(pid, usage)) : std::nullopt;
+    }
+#endif
+    // Portable fallback: peek without reaping (WNOWAIT), sleep briefly.
+    for (;;) {
+        siginfo_t info{};
+        if (::waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOHANG | WNOWAIT) == 0 &&
+            info.si_pid == pid) {
+            return wait_for(pid, usage);
+        }
+        if (remaining_ms() == 0) {
+            return std::nullopt;
+        }
+        ::usleep(2000);
+    }
+#endif
+}
+
+/// Ask a started child to stop (SIGTERM; TerminateProcess on Windows).
+/// The caller still has to wait_for() it.
+inline void kill_process(process_id pid)
+{
+#ifdef _WIN32
+    TerminateProcess(reinterpret_cast<HANDLE>(pid), 1);
+#else
+    ::kill(pid, SIGTERM);
+#endif
+}
+
+// ── Convenience ─────────────────────────────────────────────
+
+#ifndef _WIN32
+/// Pipe with both ends close-on-exec.  A child gets an end only through
+/// SpawnOptions (dup2 clears the flag), so concurrently started children
+/// never hold each other's write ends open and hide EOF.
+inline bool make_pipe(int (&fds)[2])
+{
+#ifdef __linux__
+    return ::pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (::pipe(fds) != 0)
+        return false;
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+#endif
+
+/// Start a command line through the platform shell (`/bin/sh -c`,
+/// `%COMSPEC% /c` on Windows) without waiting for it.
+inline process_id start_shell(const std::string& command, const SpawnOptions& opts = {})
+{
+#ifdef _WIN32
+    const char* comspec = std::getenv("COMSPEC");
+    const char* shell = comspec ? comspec : "C:\\Windows\\System32\\cmd.exe";
+    const char* argv[] = {shell, "/c", command.c_str(), nullptr};
+#else
+    const char* shell = "/bin/sh";
+    const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+#endif
+    return start(shell, argv, opts);
+}
+
+/// Build the child argv: { exe, argv[arg_offset..argc), nullptr }.
+inline std::vector<const char*>
+make_argv(const std::string& exe, int argc, char* argv[], int arg_offset)
+{
+    std::vector<const char*> child_argv;
+    child_argv.reserve(static_cast<size_t>(argc - arg_offset) + 2);
+    child_argv.push_back(exe.c_str());
+    for (int i = arg_offset; i < argc; ++i) {
+        child_argv.push_back(argv[i]);
+    }
+    child_argv.push_back(nullptr);
+    return child_argv;
+}
+
+/// Spawn an executable, wait for it to finish, and return its exit code.
+///
+/// @param executable  Full path to the child executable.
+/// @param argc        Original argc from main().
+/// @param argv        Original argv from main().
+/// @param arg_offset  Index of the first argument to forward (default: 2,
+///                    which skips argv[0]="dev" and argv[1]="<command>").
+/// @param usage       If non-null, receives the child's resource usage.
+/// @return            Child exit code, 126 if it could not be executed,
+///                    or -1 if no process could be created.
+inline int spawn(const std::filesystem::path& executable,
+                 int argc,
+                 char* argv[],
+                 int arg_offset = 2,
+                 ResourceUsage* usage = nullptr)
+{
+    std::string exe_str = executable.string();
+    auto child_argv = make_argv(exe_str, argc, argv, arg_offset);
+
+    auto t0 = std::chrono::steady_clock::now();
+    process_id pid = -1;
+    {
+        trace::Span span("spawn", spawn_backend_name(g_spawn_backend));
+        pid = start(exe_str.c_str(), child_argv.data());
+    }
+    if (pid == -1) {
+        // Resource exhaustion means no child at all; anything else is an
+        // exec failure, reported like a forked child would.
+        return (errno == EAGAIN || errno == ENOMEM) ? -1 : 126;
+    }
+    trace::Span span("wait", exe_str);
+    int rc = wait_for(pid, usage);
+    if (usage) {
+        usage->wall_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return rc;
+}
+
+/// Replace the current process with an executable (no fork, no wait).
+///
+/// On success this never returns: the plugin inherits the pid, so its exit
+/// code and signals reach the caller directly.  On Windows there is no
+/// true exec, so this falls back to spawn().
+///
+/// @return  126 if the exec failed (same code a forked child reports).
+inline int
+exec(const std::filesystem::path& executable, int argc, char* argv[], int arg_offset = 2)
+{
+#ifdef _WIN32
+    return spawn(executable, argc, argv, arg_offset);
+#else
+    std::string exe_str = executable.string();
+    auto child_argv = make_argv(exe_str, argc, argv, arg_offset);
+
+    // Buffered stdio output would be lost when the image is replaced.
+    std::fflush(nullptr);
+    execv(exe_str.c_str(), const_cast<char**>(child_argv.data()));
+    return 126; // execv only returns on failure
+#endif
+}
+
 } // namespace dev
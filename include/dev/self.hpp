@@ -0,0 +1,69 @@
+/**
+ * @file self.hpp
+ * @brief Location of the running dev executable.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <climits>
+#ifdef __APPLE__
+#include <cstdint>
+#include <mach-o/dyld.h>
+#else
+#include <unistd.h>
+#endif
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// Absolute path of the running executable, computed once and cached.
+///
+/// Uses the OS's own record of the image (/proc/self/exe on Linux — a
+/// single readlink, no per-component path walk) and only falls back to
+/// canonicalising argv[0] when that is unavailable.
+inline const fs::path& exe_path(const char* argv0 = nullptr)
+{
+    static const fs::path cached = [argv0] {
+        std::error_code ec;
+#ifdef _WIN32
+        wchar_t buf[MAX_PATH];
+        DWORD n = GetModuleFileNameW(nullptr, buf, MAX_PATH);
+        if (n > 0 && n < MAX_PATH) {
+            return fs::path(buf, buf + n);
+        }
+#elif defined(__APPLE__)
+        char buf[PATH_MAX];
+        std::uint32_t size = sizeof(buf);
+        if (_NSGetExecutablePath(buf, &size) == 0) {
+            return fs::weakly_canonical(fs::path(buf), ec);
+        }
+#else
+        char buf[PATH_MAX];
+        auto n = readlink("/proc/self/exe", buf, sizeof(buf));
+        if (n > 0 && static_cast<std::size_t>(n) < sizeof(buf)) {
+            return fs::path(buf, buf + n);
+        }
+#endif
+        return argv0 ? fs::weakly_canonical(fs::path(argv0), ec) : fs::path{};
+    }();
+    return cached;
+}
+
+/// Directory containing the running executable.
+inline fs::path exe_dir(const char* argv0 = nullptr)
+{
+    return exe_path(argv0).parent_path();
+}
+
+} // namespace dev
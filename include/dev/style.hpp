@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdio>
+#include <format>
 #include <string>
 #include <string_view>
 
@@ -123,4 +125,39 @@ inline std::string gray_text(std::string_view t)
     return styled(gray, t);
 }
 
+// ── Formatting without temporaries ──────────────────────────
+
+/// Text to be printed in a style.  Formatted with std::format/print, the
+/// escape codes are written straight into the output — no strings are
+/// built — and a width/alignment spec pads the visible text only.
+/// Holds a view: keep it within the print statement.
+struct Styled
+{
+    const char* code;
+    std::string_view text;
+};
+
+constexpr Styled paint(const char* style_code, std::string_view text)
+{
+    return {style_code, text};
+}
+
 } // namespace dev::style
+
+/// `{}` / `{:<22}` etc. for style::Styled (same spec as a string).
+template <>
+struct std::formatter<dev::style::Styled, char> : std::formatter<std::string_view, char>
+{
+    template <typename FormatContext>
+    auto format(const dev::style::Styled& s, FormatContext& ctx) const
+    {
+        if (!dev::style::g_colors) {
+            return std::formatter<std::string_view, char>::format(s.text, ctx);
+        }
+        std::string_view code = s.code;
+        std::string_view reset = dev::style::reset;
+        ctx.advance_to(std::copy(code.begin(), code.end(), ctx.out()));
+        auto out = std::formatter<std::string_view, char>::format(s.text, ctx);
+        return std::copy(reset.begin(), reset.end(), out);
+    }
+};
@@ -0,0 +1,175 @@
+/**
+ * @file suggest.hpp
+ * @brief "Did you mean" suggestions for unknown commands.
+ *
+ * Candidates are ranked by Levenshtein distance to what was typed,
+ * computed with the bit-parallel algorithm of Myers (1999) in Hyyrö's
+ * formulation for whole-string edit distance: the typed name becomes a
+ * 64-bit column (one bit per character), and each candidate character
+ * updates the whole column in a handful of word operations.  Scoring a
+ * candidate is O(length) instead of O(length²), and the bound stops the
+ * scan as soon as the remaining characters cannot bring the distance
+ * back under it.  Names over 64 characters fall back to the plain
+ * dynamic-programming recurrence.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dev {
+
+/// Edit distance from one fixed pattern to many texts.
+class EditDistance
+{
+public:
+    explicit EditDistance(std::string_view pattern)
+        : pattern_(pattern)
+    {
+        if (pattern.size() <= 64) {
+            for (std::size_t i = 0; i < pattern.size(); ++i) {
+                peq_[static_cast<unsigned char>(pattern[i])] |= std::uint64_t{1} << i;
+            }
+        }
+    }
+
+    /// Levenshtein distance to `text`, or `max + 1` if it exceeds `max`.
+    [[nodiscard]] std::size_t bounded(std::string_view text, std::size_t max) const
+    {
+        std::size_t m = pattern_.size();
+        std::size_t n = text.size();
+        if ((m > n ? m - n : n - m) > max) {
+            return max + 1;
+        }
+        if (m == 0 || n == 0) {
+            return std::max(m, n);
+        }
+        if (m > 64) {
+            return bounded_dp(text, max);
+        }
+
+        // Pv/Mv: vertical deltas +1/-1 of the current column; the score
+        // tracks the bottom cell, i.e. distance(pattern, text[0..j]).
+        const std::uint64_t last = std::uint64_t{1} << (m - 1);
+        std::uint64_t pv = m == 64 ? ~std::uint64_t{0} : (last << 1) - 1;
+        std::uint64_t mv = 0;
+        std::size_t score = m;
+        for (std::size_t j = 0; j < n; ++j) {
+            std::uint64_t eq = peq_[static_cast<unsigned char>(text[j])];
+            std::uint64_t xv = eq | mv;
+            std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            std::uint64_t ph = mv | ~(xh | pv);
+            std::uint64_t mh = pv & xh;
+            if (ph & last) {
+                ++score;
+            } else if (mh & last) {
+                --score;
+            }
+            // The top row is distance(ε, text[0..j]) = j + 1: always +1.
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+
+            // Each remaining character lowers the score by at most one.
+            if (score > max + (n - j - 1)) {
+                return max + 1;
+            }
+        }
+        return score <= max ? score : max + 1;
+    }
+
+private:
+    std::string_view pattern_;
+    std::array<std::uint64_t, 256> peq_{}; ///< character → positions in pattern_
+
+    /// Two-row DP for patterns longer than a machine word.
+    std::size_t bounded_dp(std::string_view text, std::size_t max) const
+    {
+        std::vector<std::size_t> prev(pattern_.size() + 1);
+        std::vector<std::size_t> cur(pattern_.size() + 1);
+        std::iota(prev.begin(), prev.end(), std::size_t{0});
+        for (std::size_t j = 1; j <= text.size(); ++j) {
+            cur[0] = j;
+            std::size_t row_min = cur[0];
+            for (std::size_t i = 1; i <= pattern_.size(); ++i) {
+                std::size_t sub = prev[i - 1] + (pattern_[i - 1] == text[j - 1] ? 0 : 1);
+                cur[i] = std::min({prev[i] + 1, cur[i - 1] + 1, sub});
+                row_min = std::min(row_min, cur[i]);
+            }
+            if (row_min > max) {
+                return max + 1;
+            }
+            std::swap(prev, cur);
+        }
+        return prev.back() <= max ? prev.back() : max + 1;
+    }
+};
+
+/// One ranked suggestion.
+struct Suggestion
+{
+    std::string_view name;
+    std::size_t distance = 0;
+};
+
+/// Largest distance worth suggesting for a name of `length` characters:
+/// one typo per three characters, at least one and at most three.
+constexpr std::size_t suggestion_distance(std::size_t length)
+{
+    return std::clamp<std::size_t>((length + 2) / 3, 1, 3);
+}
+
+/// Candidates within suggestion_distance() of `typed`, closest first
+/// (ties by name), without duplicates and at most `limit` of them.
+/// The views point into `candidates`.
+template <typename Range>
+std::vector<Suggestion> suggest(std::string_view typed, const Range& candidates, std::size_t limit = 5)
+{
+    EditDistance ed(typed);
+    auto max = suggestion_distance(typed.size());
+
+    std::vector<Suggestion> out;
+    for (const auto& c : candidates) {
+        std::string_view name = c;
+        if (name == typed) {
+            continue;
+        }
+        if (auto d = ed.bounded(name, max); d <= max) {
+            out.push_back({name, d});
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const Suggestion& a, const Suggestion& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.name < b.name;
+    });
+    out.erase(std::unique(out.begin(),
+                          out.end(),
+                          [](const Suggestion& a, const Suggestion& b) { return a.name == b.name; }),
+              out.end());
+    if (out.size() > limit) {
+        out.resize(limit);
+    }
+    return out;
+}
+
+/// The suggestion to run instead of `typed`, if autocorrect applies:
+/// exactly one candidate, and it is a single edit away.
+inline const Suggestion* unique_correction(const std::vector<Suggestion>& suggestions)
+{
+    if (suggestions.empty() || suggestions[0].distance != 1) {
+        return nullptr;
+    }
+    if (suggestions.size() > 1 && suggestions[1].distance == 1) {
+        return nullptr;
+    }
+    return &suggestions[0];
+}
+
+} // namespace dev
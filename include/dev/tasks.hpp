@@ -0,0 +1,621 @@
+/**
+ * @file tasks.hpp
+ * @brief Task runner (`dev task <name>`) — `[tasks.<name>]` sections of
+ *        dev.toml run as a dependency DAG.
+ *
+ *   [tasks.gen]
+ *   cmd = "python gen.py"
+ *   inputs = ["gen.py", "schema"]
+ *   outputs = ["src/gen.hpp"]
+ *
+ *   [tasks.build]
+ *   cmd = "cmake --build build"
+ *   deps = ["gen"]
+ *
+ * Ready tasks are spread over a small work-stealing pool; each worker
+ * runs one task at a time as a shell process (`/bin/sh -c`, `cmd /c`).
+ * A task with `inputs` is skipped when the fingerprint of its command and
+ * input files equals that of its last successful run, its outputs exist
+ * and none of its deps ran.  Fingerprints live in `.dev/tasks.state` next
+ * to dev.toml.  Paths and globs are relative to the directory of dev.toml.
+ */
+
+#pragma once
+
+#include "dev/cache.hpp"
+#include "dev/config.hpp"
+#include "dev/error.hpp"
+#include "dev/jobserver.hpp"
+#include "dev/mmap.hpp"
+#include "dev/process.hpp"
+#include "dev/style.hpp"
+#include "dev/trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+namespace dev {
+
+namespace fs = std::filesystem;
+
+/// One `[tasks.<name>]` section.
+struct Task
+{
+    std::string name;
+    std::string cmd;                  ///< shell command line
+    std::vector<std::string> deps;    ///< tasks that must succeed first
+    std::vector<std::string> inputs;  ///< globs (`*`, `?`, `**`) or directories
+    std::vector<std::string> outputs; ///< globs that must match for a skip
+};
+
+struct TaskOptions
+{
+    std::size_t jobs = 0;  ///< worker threads (0 = hardware concurrency)
+    bool force = false;    ///< run every task, ignore recorded fingerprints
+    bool dry_run = false;  ///< report what would run, start nothing
+    bool quiet = false;    ///< only report failures
+    fs::path state_file;   ///< fingerprints of successful runs (empty = none)
+
+    /// If set, every task running beyond the first needs one of its
+    /// tokens, so tasks and the makes they start share one CPU budget.
+    Jobserver* jobserver = nullptr;
+};
+
+/// All tasks defined in `cfg`, sorted by name.
+inline std::vector<Task> load_tasks(const Config& cfg)
+{
+    std::vector<Task> tasks;
+    for (auto& name : cfg.subsections("tasks")) {
+        std::string section = "tasks." + name;
+        Task t;
+        t.cmd = cfg.get(section, "cmd");
+        t.deps = cfg.get_list(section, "deps");
+        t.inputs = cfg.get_list(section, "inputs");
+        t.outputs = cfg.get_list(section, "outputs");
+        t.name = std::move(name);
+        tasks.push_back(std::move(t));
+    }
+    return tasks;
+}
+
+// ── Globs ───────────────────────────────────────────────────
+
+/// Match a `/`-separated relative path against a glob: `*` and `?` stay
+/// inside one component, `**` spans any number of them.
+inline bool glob_match(std::string_view pattern, std::string_view path)
+{
+    while (!pattern.empty()) {
+        if (pattern.starts_with("**")) {
+            pattern.remove_prefix(2);
+            if (pattern.empty()) {
+                return true;
+            }
+            // `**/` resumes at a component boundary, `**x` anywhere.
+            bool whole = pattern.starts_with('/');
+            if (whole) {
+                pattern.remove_prefix(1);
+            }
+            for (std::size_t i = 0; i <= path.size(); ++i) {
+                if ((!whole || i == 0 || path[i - 1] == '/') &&
+                    glob_match(pattern, path.substr(i))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        char c = pattern.front();
+        if (c == '*') {
+            pattern.remove_prefix(1);
+            for (std::size_t i = 0;; ++i) {
+                if (glob_match(pattern, path.substr(i))) {
+                    return true;
+                }
+                if (i == path.size() || path[i] == '/') {
+                    return false;
+                }
+            }
+        }
+        if (path.empty() || (c == '?' ? path.front() == '/' : c != path.front())) {
+            return false;
+        }
+        pattern.remove_prefix(1);
+        path.remove_prefix(1);
+    }
+    return path.empty();
+}
+
+/// Files matching `patterns` below `root`, as sorted relative generic
+/// paths.  A pattern without wildcards names a file or a whole directory.
+/// Dot-directories (.git, .dev, ...) are not descended into.
+inline std::vector<std::string> expand_globs(const std::vector<std::string>& patterns,
+                                             const fs::path& root)
+{
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& pattern : patterns) {
+        // Walk only below the components before the first wildcard.
+        auto wild = pattern.find_first_of("*?");
+        std::string_view fixed(pattern);
+        if (wild != std::string::npos) {
+            auto slash = pattern.rfind('/', wild);
+            fixed = (slash == std::string::npos) ? std::string_view{} : fixed.substr(0, slash);
+        }
+        fs::path base = root / fixed;
+
+        if (wild == std::string::npos && !fs::is_directory(base, ec)) {
+            if (fs::is_regular_file(base, ec)) {
+                files.push_back(pattern);
+            }
+            continue;
+        }
+
+        auto walk_opts = fs::directory_options::skip_permission_denied;
+        fs::recursive_directory_iterator it(base, walk_opts, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            const auto& entry = *it;
+            if (entry.is_directory(ec)) {
+                if (entry.path().filename().string().starts_with('.')) {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            if (!entry.is_regular_file(ec)) {
+                continue;
+            }
+            auto rel = entry.path().lexically_relative(root).generic_string();
+            if (wild == std::string::npos || glob_match(pattern, rel)) {
+                files.push_back(std::move(rel));
+            }
+        }
+        ec.clear();
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+// ── Fingerprints ────────────────────────────────────────────
+
+/// Hash of the command line plus every input file's path and contents.
+inline std::uint64_t task_fingerprint(const Task& task, const fs::path& root)
+{
+    std::uint64_t h = fnv1a64(task.cmd);
+    for (const auto& rel : expand_globs(task.inputs, root)) {
+        h = fnv1a64(std::string_view(rel.c_str(), rel.size() + 1), h); // path + '\0'
+        auto file = MappedFile::open(root / rel);
+        h = fnv1a64(file.view(), h);
+        h = fnv1a64(std::string_view("\0", 1), h);
+    }
+    return h;
+}
+
+/// Fingerprints of the last successful run of each task.
+class TaskState
+{
+public:
+    /// Read `path` ("<task> <hex>" lines); a missing file is an empty state.
+    explicit TaskState(fs::path path)
+        : path_(std::move(path))
+    {
+        std::ifstream ifs(path_);
+        std::string name;
+        std::string hex;
+        while (ifs >> name >> hex) {
+            hashes_[name] = std::strtoull(hex.c_str(), nullptr, 16);
+        }
+    }
+
+    [[nodiscard]] bool matches(const std::string& task, std::uint64_t hash) const
+    {
+        std::lock_guard lock(mutex_);
+        auto it = hashes_.find(task);
+        return it != hashes_.end() && it->second == hash;
+    }
+
+    void record(const std::string& task, std::uint64_t hash)
+    {
+        std::lock_guard lock(mutex_);
+        hashes_[task] = hash;
+        dirty_ = true;
+    }
+
+    void forget(const std::string& task)
+    {
+        std::lock_guard lock(mutex_);
+        dirty_ = hashes_.erase(task) > 0 || dirty_;
+    }
+
+    /// Write the state back (atomically) if anything changed.
+    bool save() const
+    {
+        std::lock_guard lock(mutex_);
+        if (!dirty_ || path_.empty()) {
+            return true;
+        }
+        std::vector<std::pair<std::string, std::uint64_t>> sorted(hashes_.begin(), hashes_.end());
+        std::sort(sorted.begin(), sorted.end());
+        std::string out;
+        for (const auto& [name, hash] : sorted) {
+            out += name + ' ' + to_hex(hash) + '\n';
+        }
+        return write_atomic(path_, out);
+    }
+
+private:
+    fs::path path_;
+    std::unordered_map<std::string, std::uint64_t> hashes_;
+    bool dirty_ = false;
+    mutable std::mutex mutex_;
+};
+
+namespace detail {
+
+// ── Work-stealing pool ──────────────────────────────────────
+
+/// Fixed set of workers, each with its own deque: a worker pops the newest
+/// item of its own deque (depth-first, warm caches) and, when that is
+/// empty, steals the oldest item of another.  Items pushed from inside a
+/// job go to the pushing worker's deque.  run() returns once every pushed
+/// item has been processed.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(std::size_t workers)
+        : queues_(std::max<std::size_t>(workers, 1))
+    {
+    }
+
+    /// Queue an item; `worker` picks the deque (wrapped).
+    void push(std::size_t item, std::size_t worker)
+    {
+        pending_.fetch_add(1);
+        {
+            auto& q = queues_[worker % queues_.size()];
+            std::lock_guard lock(q.mutex);
+            q.items.push_back(item);
+        }
+        queued_.fetch_add(1);
+        std::lock_guard lock(wake_mutex_); // no lost wake-up between check and wait
+        wake_.notify_one();
+    }
+
+    /// Process items with `job(item, worker)` on all workers until none
+    /// are left.  `job` may push() more.
+    template <typename Job>
+    void run(Job&& job)
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t w = 1; w < queues_.size(); ++w) {
+            threads.emplace_back([this, w, &job] { work(w, job); });
+        }
+        work(0, job);
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> items;
+    };
+
+    std::vector<Queue> queues_;
+    std::atomic<std::size_t> pending_{0}; ///< pushed, not yet finished
+    std::atomic<std::size_t> queued_{0};  ///< sitting in some deque
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+
+    bool try_pop(std::size_t self, std::size_t& item)
+    {
+        for (std::size_t k = 0; k < queues_.size(); ++k) {
+            auto& q = queues_[(self + k) % queues_.size()];
+            std::lock_guard lock(q.mutex);
+            if (q.items.empty()) {
+                continue;
+            }
+            if (k == 0) {
+                item = q.items.back();
+                q.items.pop_back();
+            } else {
+                item = q.items.front();
+                q.items.pop_front();
+            }
+            queued_.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Job>
+    void work(std::size_t self, Job& job)
+    {
+        for (;;) {
+            std::size_t item = 0;
+            if (try_pop(self, item)) {
+                job(item, self);
+                if (pending_.fetch_sub(1) == 1) {
+                    std::lock_guard lock(wake_mutex_);
+                    wake_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock lock(wake_mutex_);
+            wake_.wait(lock, [this] { return pending_.load() == 0 || queued_.load() > 0; });
+            if (pending_.load() == 0) {
+                return;
+            }
+        }
+    }
+};
+
+/// Jobserver tokens for the pool's workers: the first running task uses
+/// dev's implicit slot, every further one holds a token (as in dev par).
+/// Jobserver is not thread-safe, hence the mutex.
+class TokenGate
+{
+public:
+    explicit TokenGate(Jobserver* js)
+        : js_(js)
+    {
+    }
+
+    /// Block until one more task may run.
+    void enter()
+    {
+        std::unique_lock lock(mutex_);
+#ifndef _WIN32
+        while (js_ && running_ > 0 && !js_->try_acquire()) {
+            lock.unlock();
+            // Readable when a token comes back; the timeout covers the
+            // last running task finishing, which returns none.
+            pollfd p{js_->wait_fd(), POLLIN, 0};
+            ::poll(&p, 1, 50);
+            lock.lock();
+        }
+#endif
+        ++running_;
+    }
+
+    /// A task entered with enter() has finished.
+    void leave()
+    {
+        std::lock_guard lock(mutex_);
+        --running_;
+        if (js_ && js_->held() > 0) {
+            js_->release(); // keeps held == running - 1
+        }
+    }
+
+private:
+    Jobserver* js_;
+    std::mutex mutex_;
+    std::size_t running_ = 0;
+};
+
+} // namespace detail
+
+// ── Runner ──────────────────────────────────────────────────
+
+/// Run `targets` and, first, everything they depend on.
+///
+/// Prints one status line per task on stderr.  Must be called with the
+/// task root (the directory of dev.toml) as the working directory.
+///
+/// @return  0 if every task succeeded (or was up to date), otherwise the
+///          exit code of the first task to fail; nothing new starts after
+///          a failure.  Unknown tasks and dependency cycles are
+///          Error::InvalidUsage.
+inline int run_tasks(const std::vector<Task>& all,
+                     const std::vector<std::string>& targets,
+                     const TaskOptions& opts = {})
+{
+    namespace s = style;
+
+    std::unordered_map<std::string_view, std::size_t> by_name;
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        by_name.emplace(all[i].name, i);
+    }
+
+    // ── Plan: the targets' dependency closure, cycle-checked ──
+    enum class Mark : std::uint8_t
+    {
+        None,
+        Visiting,
+        Done,
+    };
+    std::vector<Mark> mark(all.size(), Mark::None);
+    std::vector<std::size_t> order; // topological
+    auto visit = [&](auto& self, std::string_view name, std::string_view from) -> bool {
+        auto it = by_name.find(name);
+        if (it == by_name.end()) {
+            if (from.empty()) {
+                std::println(stderr, "{} unknown task '{}'", s::red_text("error:"), name);
+            } else {
+                std::println(stderr,
+                             "{} task '{}' depends on unknown task '{}'",
+                             s::red_text("error:"),
+                             from,
+                             name);
+            }
+            return false;
+        }
+        auto i = it->second;
+        if (mark[i] == Mark::Done) {
+            return true;
+        }
+        if (mark[i] == Mark::Visiting) {
+            std::println(stderr,
+                         "{} dependency cycle through task '{}'",
+                         s::red_text("error:"),
+                         name);
+            return false;
+        }
+        mark[i] = Mark::Visiting;
+        for (const auto& dep : all[i].deps) {
+            if (!self(self, dep, all[i].name)) {
+                return false;
+            }
+        }
+        mark[i] = Mark::Done;
+        order.push_back(i);
+        return true;
+    };
+    for (const auto& t : targets) {
+        if (!visit(visit, t, {})) {
+            return static_cast<int>(Error::InvalidUsage);
+        }
+    }
+
+    // Dense indices over the plan.
+    const std::size_t n = order.size();
+    std::vector<std::size_t> slot(all.size());
+    for (std::size_t k = 0; k < n; ++k) {
+        slot[order[k]] = k;
+    }
+    std::vector<std::vector<std::size_t>> dependents(n);
+    auto waiting = std::make_unique<std::atomic<std::size_t>[]>(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        const auto& task = all[order[k]];
+        waiting[k].store(task.deps.size());
+        for (const auto& dep : task.deps) {
+            dependents[slot[by_name.at(dep)]].push_back(k);
+        }
+    }
+
+    // ── Execute ──
+    enum class Outcome : std::uint8_t
+    {
+        NotRun,
+        Ran,
+        UpToDate,
+        Failed,
+    };
+    std::vector<Outcome> outcome(n, Outcome::NotRun);
+    auto any_dep_ran = std::make_unique<std::atomic<bool>[]>(n);
+    std::atomic<int> failure{0};
+    std::mutex print_mutex;
+
+    const fs::path root = fs::current_path();
+    TaskState state(opts.state_file);
+    std::size_t workers = opts.jobs ? opts.jobs : std::thread::hardware_concurrency();
+    detail::WorkStealingPool pool(std::min(std::max<std::size_t>(workers, 1), n));
+    detail::TokenGate tokens(opts.jobserver);
+
+    auto job = [&](std::size_t k, std::size_t worker) {
+        const Task& task = all[order[k]];
+        if (failure.load() != 0) {
+            return; // stays NotRun, reported as cancelled
+        }
+        trace::Span span("task", task.name);
+        auto t0 = std::chrono::steady_clock::now();
+
+        std::uint64_t fp = 0;
+        bool up_to_date = false;
+        if (!task.inputs.empty()) {
+            fp = task_fingerprint(task, root);
+            up_to_date = !opts.force && !any_dep_ran[k].load() && state.matches(task.name, fp) &&
+                         std::all_of(task.outputs.begin(), task.outputs.end(), [&](auto& out) {
+                             return !expand_globs({out}, root).empty();
+                         });
+        }
+
+        int rc = 0;
+        if (up_to_date) {
+            outcome[k] = Outcome::UpToDate;
+        } else if (opts.dry_run) {
+            outcome[k] = Outcome::Ran;
+        } else {
+            if (!opts.quiet) {
+                std::lock_guard lock(print_mutex);
+                std::println(stderr, "{} {}: {}", s::cyan_text("▶"), task.name, task.cmd);
+            }
+            if (!task.cmd.empty()) {
+                tokens.enter();
+                auto pid = start_shell(task.cmd);
+                rc = (pid == -1) ? 127 : wait_for(pid);
+                tokens.leave();
+            }
+            outcome[k] = (rc == 0) ? Outcome::Ran : Outcome::Failed;
+            if (rc == 0 && !task.inputs.empty()) {
+                state.record(task.name, fp);
+            } else if (rc != 0) {
+                state.forget(task.name);
+                int none = 0;
+                failure.compare_exchange_strong(none, rc);
+            }
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        if (!opts.quiet || outcome[k] == Outcome::Failed) {
+            std::lock_guard lock(print_mutex);
+            if (outcome[k] == Outcome::UpToDate) {
+                std::println(stderr, "{} {} up to date", s::dim_text("↷"), task.name);
+            } else if (opts.dry_run) {
+                std::println(stderr, "{} {}: {}", s::yellow_text("○"), task.name, task.cmd);
+            } else if (rc == 0) {
+                std::println(stderr, "{} {} ({:.2f}s)", s::green_text("✓"), task.name, seconds);
+            } else {
+                std::println(stderr,
+                             "{} {} exited {} ({:.2f}s)",
+                             s::red_text("✗"),
+                             task.name,
+                             rc,
+                             seconds);
+            }
+        }
+        if (rc != 0) {
+            return;
+        }
+        for (auto d : dependents[k]) {
+            if (outcome[k] == Outcome::Ran) {
+                any_dep_ran[d].store(true);
+            }
+            if (waiting[d].fetch_sub(1) == 1) {
+                pool.push(d, worker);
+            }
+        }
+    };
+
+    std::size_t roots = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+        if (all[order[k]].deps.empty()) {
+            pool.push(k, roots++);
+        }
+    }
+    pool.run(job);
+
+    if (!opts.dry_run) {
+        state.save();
+    }
+    if (!opts.quiet) {
+        for (std::size_t k = 0; k < n; ++k) {
+            if (outcome[k] == Outcome::NotRun) {
+                std::println(stderr, "{} {} cancelled", s::dim_text("–"), all[order[k]].name);
+            }
+        }
+    }
+    return failure.load();
+}
+
+} // namespace dev
@@ -0,0 +1,259 @@
+/**
+ * @file trace.hpp
+ * @brief Chrome trace-event output for dispatcher phases (`--trace=<file>`).
+ *
+ * The trace file is a JSON array that any process may extend by appending
+ * `,{event}` with a single O_APPEND write:
+ *
+ *   [{"name":"process_name","ph":"M",...}
+ *   ,{"name":"config","ph":"X","ts":...,"dur":...,"pid":...,"tid":...}
+ *   ...
+ *   ]
+ *
+ * dev writes the opening metadata event and the closing `]`; everything in
+ * between is one event per write.  Children inherit the open descriptor as
+ * `DEV_TRACE_FD` and the path as `DEV_TRACE_FILE`, so plugins add their own
+ * spans to the same timeline.  Timestamps are microseconds of
+ * std::chrono::steady_clock (CLOCK_MONOTONIC on Linux), which is shared by
+ * every process on the machine.
+ *
+ * Load the file in chrome://tracing or https://ui.perfetto.dev.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dev::trace {
+
+namespace fs = std::filesystem;
+
+namespace detail {
+
+inline int g_fd = -1;
+inline bool g_owner = false; ///< true in the dev that created the file
+inline std::uint64_t g_opened_at = 0;
+
+inline int current_pid()
+{
+#ifdef _WIN32
+    return _getpid();
+#else
+    return static_cast<int>(::getpid());
+#endif
+}
+
+inline void write_raw(std::string_view data)
+{
+#ifdef _WIN32
+    _write(g_fd, data.data(), static_cast<unsigned>(data.size()));
+#else
+    // One write per event: with O_APPEND concurrent writers never interleave.
+    [[maybe_unused]] auto n = ::write(g_fd, data.data(), data.size());
+#endif
+}
+
+inline void append_escaped(std::string& out, std::string_view s)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+    for (char c : s) {
+        auto u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += hex[u >> 4];
+            out += hex[u & 0xf];
+        } else {
+            out += c;
+        }
+    }
+}
+
+inline void metadata(std::string_view prefix, std::string_view process_name)
+{
+    auto pid = std::to_string(current_pid());
+    std::string ev(prefix);
+    ev += R"({"name":"process_name","ph":"M","pid":)" + pid + R"(,"tid":)" + pid +
+          R"(,"args":{"name":")";
+    append_escaped(ev, process_name);
+    ev += "\"}}";
+    write_raw(ev);
+}
+
+} // namespace detail
+
+/// True if a trace is being recorded by this process.
+inline bool enabled()
+{
+    return detail::g_fd >= 0;
+}
+
+/// Microseconds on the shared monotonic clock.
+inline std::uint64_t now_us()
+{
+    auto t = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(t).count());
+}
+
+/// Record a complete ("X") event.  `info` ends up in args.detail.
+inline void complete(std::string_view name,
+                     std::uint64_t start_us,
+                     std::uint64_t dur_us,
+                     std::string_view info = {})
+{
+    if (!enabled()) {
+        return;
+    }
+    auto pid = std::to_string(detail::current_pid());
+    std::string ev = "\n,{\"name\":\"";
+    detail::append_escaped(ev, name);
+    ev += R"(","cat":"dev","ph":"X","ts":)" + std::to_string(start_us) +
+          R"(,"dur":)" + std::to_string(dur_us) + R"(,"pid":)" + pid + R"(,"tid":)" + pid;
+    if (!info.empty()) {
+        ev += R"(,"args":{"detail":")";
+        detail::append_escaped(ev, info);
+        ev += "\"}";
+    }
+    ev += '}';
+    detail::write_raw(ev);
+}
+
+/// Finish the trace.  In the owning dev this records the overall "dev"
+/// span and closes the JSON array; in a plugin it just drops the fd.
+inline void close()
+{
+    if (!enabled()) {
+        return;
+    }
+    if (detail::g_owner) {
+        complete("dev", detail::g_opened_at, now_us() - detail::g_opened_at);
+        detail::write_raw("\n]\n");
+#ifdef _WIN32
+        _close(detail::g_fd);
+#else
+        ::close(detail::g_fd);
+#endif
+    }
+    detail::g_fd = -1;
+}
+
+/// Start a new trace at `path` (truncated) and export it to children.
+/// The trace is closed automatically at exit.
+inline bool open(const fs::path& path)
+{
+    if (enabled()) {
+        return true;
+    }
+    auto start = now_us();
+#ifdef _WIN32
+    int fd = _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_APPEND | _O_BINARY,
+                    _S_IREAD | _S_IWRITE);
+#else
+    // Deliberately no O_CLOEXEC: plugins inherit the descriptor.
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+#endif
+    if (fd < 0) {
+        return false;
+    }
+    detail::g_fd = fd;
+    detail::g_owner = true;
+    detail::g_opened_at = start;
+    detail::metadata("[", "dev");
+
+    std::error_code ec;
+    auto abs = fs::absolute(path, ec);
+    auto fd_str = std::to_string(fd);
+#ifdef _WIN32
+    _putenv_s("DEV_TRACE_FD", fd_str.c_str());
+    _putenv_s("DEV_TRACE_FILE", abs.string().c_str());
+#else
+    ::setenv("DEV_TRACE_FD", fd_str.c_str(), 1);
+    ::setenv("DEV_TRACE_FILE", abs.c_str(), 1);
+#endif
+    std::atexit(close);
+    return true;
+}
+
+/// For plugins: join the trace started by the parent dev, if any.
+/// Uses the inherited `DEV_TRACE_FD`, falling back to opening
+/// `DEV_TRACE_FILE` for append.  `process_name` labels this process's row.
+inline bool attach_from_env(std::string_view process_name)
+{
+    if (enabled()) {
+        return true;
+    }
+    int fd = -1;
+#ifndef _WIN32
+    if (const char* s = std::getenv("DEV_TRACE_FD"); s && *s) {
+        int candidate = std::atoi(s);
+        if (candidate > 2 && ::fcntl(candidate, F_GETFL) >= 0) {
+            fd = candidate;
+        }
+    }
+#endif
+    if (fd < 0) {
+        if (const char* file = std::getenv("DEV_TRACE_FILE"); file && *file) {
+#ifdef _WIN32
+            fd = _open(file, _O_WRONLY | _O_APPEND | _O_BINARY);
+#else
+            fd = ::open(file, O_WRONLY | O_APPEND | O_CLOEXEC);
+#endif
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+    detail::g_fd = fd;
+    detail::metadata("\n,", process_name);
+    return true;
+}
+
+/// Records the lifetime of a scope as one complete event.  Costs a single
+/// branch when tracing is off.
+class Span
+{
+public:
+    explicit Span(std::string_view name, std::string_view info = {})
+    {
+        if (enabled()) {
+            name_ = name;
+            info_ = info;
+            start_ = now_us();
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    ~Span()
+    {
+        if (enabled() && start_ != 0) {
+            complete(name_, start_, now_us() - start_, info_);
+        }
+    }
+
+private:
+    std::string name_;
+    std::string info_;
+    std::uint64_t start_ = 0;
+};
+
+} // namespace dev::trace
@@ -0,0 +1,70 @@
+#!/usr/bin/env bash
+# ==============================================================================
+# Script: syscall-budget.sh
+# Hitung syscall yang dilakukan dispatcher `dev` per command (via strace) dan
+# bandingkan dengan budget.  Angka = syscall di atas `dev --version`, jadi
+# biaya dynamic loader + libc init tidak ikut dihitung.
+#
+# Usage:  scripts/syscall-budget.sh [path/to/Dev] [plugin]
+#         (default: build/bin/Dev, plugin "hello")
+#
+# Jalankan dari root project (tanpa dev.toml lokal) dengan index sudah hangat.
+# ==============================================================================
+
+set -euo pipefail
+
+DEV="${1:-build/bin/Dev}"
+PLUGIN="${2:-hello}"
+
+if ! command -v strace >/dev/null 2>&1; then
+    echo "syscall-budget: strace not found" >&2
+    exit 2
+fi
+
+# Budget per command (syscall di atas baseline --version).
+#   dispatch  : config lookup + plugin dirs + 1 stat per dir tried + spawn/wait
+#   not-found : config lookup + plugin dirs + 1 stat per dir + error output
+#   list      : dispatch phases + plugins.toml lookup + index open/validate,
+#               plus 1 stat per plugin (index entry stamps)
+# Mode --exec tidak diukur: plugin berjalan di pid yang sama sehingga
+# syscall-nya ikut terhitung.
+plugins=$(find "$(dirname "$DEV")/plugins" plugins -maxdepth 1 -type f -printf '%f\n' \
+    2>/dev/null | sort -u | wc -l)
+declare -A BUDGET=(
+    [dispatch]=16
+    [not-found]=14
+    [list]=$((24 + plugins))
+)
+
+count() {
+    local log
+    log="$(mktemp)"
+    # Tanpa -f: hanya proses dev, bukan plugin yang di-spawn.
+    strace -qq -o "$log" "$DEV" "$@" >/dev/null 2>&1 || true
+    grep -vc '^+++' "$log"
+    rm -f "$log"
+}
+
+"$DEV" list >/dev/null 2>&1 || true # hangatkan plugin index
+
+base="$(count --version)"
+declare -A CMD=(
+    [dispatch]="$PLUGIN"
+    [not-found]="no-such-command-$$"
+    [list]="list"
+)
+
+status=0
+printf '%-10s %6s %6s\n' "command" "used" "budget"
+for name in dispatch not-found list; do
+    # shellcheck disable=SC2086
+    used=$(( $(count ${CMD[$name]}) - base ))
+    mark=""
+    if (( used > BUDGET[$name] )); then
+        mark="  ✗ over budget"
+        status=1
+    fi
+    printf '%-10s %6d %6d%s\n' "$name" "$used" "${BUDGET[$name]}" "$mark"
+done
+
+exit "$status"
@@ -4,199 +4,955 @@
  */
 
 #include "dev.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
+#include <format>
+#include <optional>
 #include <print>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace s = dev::style;
 
 // ── Globals ─────────────────────────────────────────────────
 
-static dev::Config g_config;
-static std::vector<dev::fs::path> g_plugin_dirs;
-static std::unordered_map<std::string, std::string> g_aliases;
-static dev::Config g_meta;
+static const char* g_argv0 = nullptr;
 static bool g_verbose = false;
 static bool g_quiet = false;
+static int g_exec = -1; // -1 = use config, 0 = --no-exec, 1 = --exec
 
-static void load_config(const char* argv0)
+/// Resource summary after the plugin exits (--time, [dispatch] time).
+enum class TimeMode
 {
-    g_config = dev::Config::find(argv0);
-    g_plugin_dirs = dev::find_all_plugin_dirs(argv0, g_config);
-    g_aliases = g_config.get_section("alias");
+    Config, ///< not given on the command line
+    Off,
+    Text,
+    Json,
+};
+static TimeMode g_time = TimeMode::Config;
 
-    if (dev::fs::exists("plugins.toml")) {
-        g_meta = dev::Config::load("plugins.toml");
+// ── Lazy startup phases ─────────────────────────────────────
+//
+// State is loaded on first use so each command only pays for what it
+// touches:
+//   --version         nothing
+//   <plugin>          config (aliases, [dispatch]) + plugin dirs
+//   list / help       + plugins.toml location + plugin index
+
+static const dev::Config& config()
+{
+    static const dev::Config cfg = [] {
+        dev::trace::Span span("config");
+        return dev::Config::find(g_argv0);
+    }();
+    return cfg;
+}
+
+static const std::vector<dev::fs::path>& plugin_dirs()
+{
+    static const std::vector<dev::fs::path> dirs = [] {
+        const auto& cfg = config(); // traced separately
+        dev::trace::Span span("plugin dirs");
+        return dev::find_all_plugin_dirs(g_argv0, cfg);
+    }();
+    return dirs;
+}
+
+static const dev::fs::path& meta_path()
+{
+    static const dev::fs::path path = [] {
+        dev::trace::Span span("plugins.toml lookup");
+        if (dev::fs::exists("plugins.toml"))
+            return dev::fs::absolute("plugins.toml");
+        auto p = dev::exe_dir(g_argv0) / "plugins.toml";
+        return dev::fs::exists(p) ? p : dev::fs::path{};
+    }();
+    return path;
+}
+
+static TimeMode time_mode()
+{
+    if (g_time != TimeMode::Config)
+        return g_time;
+    auto value = config().get("dispatch", "time");
+    if (value == "json")
+        return TimeMode::Json;
+    return config().get_bool("dispatch", "time") ? TimeMode::Text : TimeMode::Off;
+}
+
+/// Human-readable size from KiB.
+static std::string format_kb(long kb)
+{
+    if (kb >= 1024 * 1024)
+        return std::format("{:.1f} GiB", static_cast<double>(kb) / (1024.0 * 1024.0));
+    if (kb >= 1024)
+        return std::format("{:.1f} MiB", static_cast<double>(kb) / 1024.0);
+    return std::format("{} KiB", kb);
+}
+
+/// Print the plugin's resource usage on stderr.  High %cpu with few
+/// voluntary switches points at CPU-bound work, major faults and many
+/// voluntary switches at I/O, a large max RSS at memory.
+static void report_usage(std::string_view command, int rc, const dev::ResourceUsage& u, bool json)
+{
+    double cpu = (u.wall_s > 0) ? 100.0 * (u.user_s + u.sys_s) / u.wall_s : 0.0;
+    if (json) {
+        std::println(stderr,
+                     R"({{"command":{:?},"exit":{},"wall_s":{:.6f},"user_s":{:.6f},)"
+                     R"("sys_s":{:.6f},"cpu_pct":{:.1f},"max_rss_kb":{},"major_faults":{},)"
+                     R"("minor_faults":{},"voluntary_cs":{},"involuntary_cs":{}}})",
+                     command,
+                     rc,
+                     u.wall_s,
+                     u.user_s,
+                     u.sys_s,
+                     cpu,
+                     u.max_rss_kb,
+                     u.major_faults,
+                     u.minor_faults,
+                     u.voluntary_switches,
+                     u.involuntary_switches);
+        return;
+    }
+    std::println(stderr,
+                 "{} {} {:.2f}s wall  {:.2f}s user  {:.2f}s sys  {:.0f}% cpu  {} max rss",
+                 s::dim_text("dev:"),
+                 command,
+                 u.wall_s,
+                 u.user_s,
+                 u.sys_s,
+                 cpu,
+                 format_kb(u.max_rss_kb));
+    std::println(stderr,
+                 "{} faults {} major / {} minor  ctx switches {} vol / {} invol",
+                 s::dim_text("    "),
+                 u.major_faults,
+                 u.minor_faults,
+                 u.voluntary_switches,
+                 u.involuntary_switches);
+}
+
+/// Jobserver shared with every plugin: the one inherited from make, else
+/// one created when `DEV_JOBS` / `[jobserver] jobs` (N or "auto") asks.
+static dev::Jobserver* jobserver()
+{
+    static std::optional<dev::Jobserver> js = []() -> std::optional<dev::Jobserver> {
+        if (auto inherited = dev::Jobserver::from_env())
+            return inherited;
+
+        std::string jobs;
+        if (const char* env = std::getenv("DEV_JOBS"))
+            jobs = env;
+        else
+            jobs = config().get("jobserver", "jobs");
+        if (jobs.empty())
+            return std::nullopt;
+
+        std::size_t slots = (jobs == "auto") ? std::thread::hardware_concurrency()
+                                             : static_cast<std::size_t>(std::atoi(jobs.c_str()));
+        auto created = dev::Jobserver::create(std::max<std::size_t>(slots, 1));
+        if (created) {
+            created->export_env();
+            if (g_verbose) {
+                std::println(stderr, "{} jobserver: {} slots", s::dim_text("dev:"), slots);
+            }
+        }
+        return created;
+    }();
+    return js ? &*js : nullptr;
+}
+
+static void select_spawn_backend()
+{
+    // Env wins over config so benchmarks can switch without editing files.
+    std::string name;
+    if (const char* env = std::getenv("DEV_SPAWN_BACKEND"))
+        name = env;
+    else
+        name = config().get("process", "backend");
+    if (name.empty())
+        return;
+
+    if (auto backend = dev::parse_spawn_backend(name)) {
+        dev::g_spawn_backend = *backend;
     } else {
-        auto exe = dev::fs::weakly_canonical(dev::fs::path(argv0));
-        auto p = exe.parent_path() / "plugins.toml";
-        if (dev::fs::exists(p))
-            g_meta = dev::Config::load(p);
+        std::println(stderr, "{} unknown spawn backend '{}' (fork, vfork, posix_spawn)",
+                     s::yellow_text("dev:"), name);
     }
 }
 
+/// Plugin names + descriptions, served from the on-disk index when fresh.
+static dev::PluginIndex open_index()
+{
+    const auto& dirs = plugin_dirs();
+    const auto& meta = meta_path();
+    bool persist = config().get_bool("plugins", "index", true);
+
+    dev::trace::Span span("plugin index");
+    auto index = dev::PluginIndex::open(dirs, meta, persist);
+    if (g_verbose) {
+        std::println(stderr,
+                     "{} plugin index {}",
+                     s::dim_text("dev:"),
+                     index.from_cache() ? "hit" : "rebuilt");
+        for (const auto& scan : index.scans()) {
+            std::println(stderr,
+                         "{}   scanned {} — {} plugins in {:.2f} ms{}",
+                         s::dim_text("dev:"),
+                         scan.dir.string(),
+                         scan.names.size(),
+                         static_cast<double>(scan.elapsed.count()) / 1000.0,
+                         scan.ok ? "" : " (unreadable)");
+        }
+    }
+    return index;
+}
+
+/// One row of the command listing.
+struct CommandEntry
+{
+    std::string_view name;
+    std::string_view description;
+};
+
+/// Bundled plugins (DEV_MULTICALL) merged into the plugin index, sorted.
+/// The views point into `index` and static plugin metadata.
+static std::vector<CommandEntry> list_commands(const dev::PluginIndex& index)
+{
+    std::vector<CommandEntry> out;
+    out.reserve(index.size() + dev::bundled_plugins().size());
+    for (std::size_t i = 0; i < index.size(); ++i) {
+        auto e = index[i];
+        if (!dev::find_bundled_plugin(e.name, config()))
+            out.push_back({e.name, e.description});
+    }
+    for (const auto& b : dev::bundled_plugins()) {
+        if (dev::find_bundled_plugin(b.name, config())) {
+            const char* desc = b.entry()->description;
+            out.push_back({b.name, desc ? desc : ""});
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+    return out;
+}
+
+/// Everything `dev <name>` can run — plugins, bundled plugins, aliases
+/// and built-ins — as candidates for "did you mean".  Views into `index`
+/// and the config.
+static std::vector<std::string_view> command_names(const dev::PluginIndex& index)
+{
+    std::vector<std::string_view> names;
+    for (const auto& c : list_commands(index))
+        names.push_back(c.name);
+    for (const auto& e : config().section("alias")) {
+        if (!e.is_list)
+            names.push_back(e.key);
+    }
+    names.insert(names.end(), dev::builtin_commands.begin(), dev::builtin_commands.end());
+    return names;
+}
+
+static void print_suggestions(const std::vector<dev::Suggestion>& suggestions)
+{
+    if (suggestions.empty())
+        return;
+    std::println(stderr, "  did you mean:");
+    for (const auto& sug : suggestions)
+        std::println(stderr, "    {}", s::cyan_text(sug.name));
+}
+
+/// "command not found" plus the closest known commands.
+static void report_not_found(std::string_view command)
+{
+    std::println(stderr, "{} command '{}' not found", s::red_text("dev:"), command);
+    auto index = open_index();
+    print_suggestions(dev::suggest(command, command_names(index)));
+}
+
 // ── Commands ────────────────────────────────────────────────
 
+/// The help screen, written with one write() (see dev/output.hpp).
 static void print_usage()
 {
-    auto plugins = dev::list_plugins(g_plugin_dirs);
-
-    std::println("{}",
-                 s::bold_text("dev") + " " + s::dim_text("v" + std::string(dev::version)) +
-                     " — lightweight CLI dispatcher");
-    std::println("");
-    std::println("{}  dev <command> [args...]", s::yellow_text("usage:"));
-    std::println("");
-    std::println("{}", s::bold_text("options:"));
-    std::println("  {}       Show this help message", s::cyan_text("-h, --help"));
-    std::println("  {}    Show version information", s::cyan_text("-v, --version"));
-    std::println("  {}     Suppress non-essential output", s::cyan_text("-q, --quiet"));
-    std::println("  {}   Extra detail (config, search)", s::cyan_text("-V, --verbose"));
-    std::println("");
-    std::println("{}", s::bold_text("built-in commands:"));
-    std::println("  {}             List available plugin commands", s::cyan_text("list"));
-    std::println("  {}       Show help for a plugin command", s::cyan_text("help <cmd>"));
-    std::println("  {} Generate shell completions", s::cyan_text("completion"));
-    std::println("");
+    auto index = open_index();
+    auto plugins = list_commands(index);
+
+    dev::OutputBuffer out;
+    auto cyan = [](std::string_view t) { return s::paint(s::cyan, t); };
+    auto bold = [](std::string_view t) { return s::paint(s::bold, t); };
+
+    auto version = "v" + std::string(dev::version);
+    out.println("{} {} — lightweight CLI dispatcher", bold("dev"), s::paint(s::dim, version));
+    out.println();
+    out.println("{}  dev <command> [args...]", s::paint(s::yellow, "usage:"));
+    out.println();
+    out.println("{}", bold("options:"));
+    out.println("  {}       Show this help message", cyan("-h, --help"));
+    out.println("  {}    Show version information", cyan("-v, --version"));
+    out.println("  {}     Suppress non-essential output", cyan("-q, --quiet"));
+    out.println("  {}   Extra detail (config, search)", cyan("-V, --verbose"));
+    out.println("  {}          Replace dev with the plugin (no fork)", cyan("--exec"));
+    out.println("  {}       Always fork + wait for the plugin", cyan("--no-exec"));
+    out.println("  {} Write a Chrome trace of dispatch phases", cyan("--trace=<file>"));
+    out.println("  {}  CPU/memory/faults summary (--time=json)", cyan("--time[=json]"));
+    out.println();
+    out.println("{}", bold("built-in commands:"));
+    out.println("  {}             List available plugin commands", cyan("list"));
+    out.println("  {}       Show help for a plugin command (cached)", cyan("help <cmd>"));
+    out.println("  {}        Help of every command, captured concurrently", cyan("help --all"));
+    out.println("  {} Generate shell completions", cyan("completion"));
+    out.println("  {} Resident dispatcher (start|stop|status|run)", cyan("daemon <op>"));
+    out.println("  {} Run plugins concurrently (-j N, --group, --fail-fast)", cyan("par a -- b"));
+    out.println("  {} Pipe plugins stdout → stdin (--tap=N:FILE, pipefail)", cyan("pipe a -- b"));
+    out.println("  {}  Run dev.toml [tasks.*] as a DAG (-j N, --force)", cyan("task <name>"));
+    out.println();
 
     if (plugins.empty()) {
-        std::println("{}", s::dim_text("plugins: (none)"));
+        out.println("{}", s::paint(s::dim, "plugins: (none)"));
     } else {
-        std::println("{}", s::bold_text("plugins:"));
-        for (const auto& name : plugins) {
-            auto desc = g_meta.get(name, "description");
+        out.println("{}", bold("plugins:"));
+        for (const auto& [name, desc] : plugins) {
             if (desc.empty()) {
-                std::println("  {}", s::cyan_text(name));
+                out.println("  {}", cyan(name));
             } else {
-                std::println("  {:<22} {}", s::cyan_text(name), s::dim_text(desc));
+                out.println("  {:<22} {}", cyan(name), s::paint(s::dim, desc));
             }
         }
     }
 
-    if (!g_aliases.empty()) {
-        std::println("");
-        std::println("{}", s::bold_text("aliases:"));
-        for (const auto& [alias, target] : g_aliases) {
-            std::println("  {:<22} {} {}", s::cyan_text(alias), s::dim_text("→"), target);
+    if (auto aliases = config().section("alias"); !aliases.empty()) {
+        out.println();
+        out.println("{}", bold("aliases:"));
+        for (const auto& e : aliases) {
+            if (!e.is_list) {
+                out.println("  {:<22} {} {}", cyan(e.key), s::paint(s::dim, "→"), e.value);
+            }
         }
     }
 
-    if (g_verbose && !g_config.empty()) {
-        std::println("");
-        std::println("{} {}", s::dim_text("config:"), g_config.path().string());
-        std::println("{}", s::dim_text("plugin dirs:"));
-        for (const auto& d : g_plugin_dirs) {
-            std::println("  {}", d.string());
+    if (g_verbose && !config().empty()) {
+        out.println();
+        out.println("{} {}", s::paint(s::dim, "config:"), config().path().string());
+        out.println("{}", s::paint(s::dim, "plugin dirs:"));
+        for (const auto& d : plugin_dirs()) {
+            out.println("  {}", d.string());
         }
     }
 }
 
+/// `dev list`, written with one write() however many plugins there are.
 static int cmd_list()
 {
-    auto plugins = dev::list_plugins(g_plugin_dirs);
+    auto index = open_index();
+    auto plugins = list_commands(index);
 
+    dev::OutputBuffer out;
     if (plugins.empty()) {
-        std::println("No plugins found.");
+        out.println("No plugins found.");
         if (!g_quiet) {
-            std::println("");
-            std::println("Place executable files in the plugins/ directory.");
+            out.println();
+            out.println("Place executable files in the plugins/ directory.");
         }
         return 0;
     }
 
     if (!g_quiet) {
-        std::println("{}", s::bold_text("Available commands:"));
-        std::println("");
+        out.println("{}", s::paint(s::bold, "Available commands:"));
+        out.println();
     }
 
-    for (const auto& name : plugins) {
-        auto desc = g_meta.get(name, "description");
+    for (const auto& [name, desc] : plugins) {
         if (desc.empty()) {
-            std::println("  {}", s::cyan_text(name));
+            out.println("  {}", s::paint(s::cyan, name));
         } else {
-            std::println("  {:<22} {}", s::cyan_text(name), desc);
+            out.println("  {:<22} {}", s::paint(s::cyan, name), desc);
         }
     }
 
-    if (!g_aliases.empty() && !g_quiet) {
-        std::println("");
-        std::println("{}", s::bold_text("Aliases:"));
-        std::println("");
-        for (const auto& [alias, target] : g_aliases) {
-            std::println("  {:<22} {} {}", s::cyan_text(alias), s::dim_text("→"), target);
+    if (auto aliases = config().section("alias"); !aliases.empty() && !g_quiet) {
+        out.println();
+        out.println("{}", s::paint(s::bold, "Aliases:"));
+        out.println();
+        for (const auto& e : aliases) {
+            if (!e.is_list) {
+                out.println("  {:<22} {} {}",
+                            s::paint(s::cyan, e.key),
+                            s::paint(s::dim, "→"),
+                            e.value);
+            }
         }
     }
 
     return 0;
 }
 
+/// Cached `--help` output (dev/helpcache.hpp); `[help] cache = false`
+/// turns it off.
+static dev::HelpCache help_cache()
+{
+    auto dir = dev::cache_dir();
+    if (dir.empty() || !config().get_bool("help", "cache", true))
+        return dev::HelpCache({});
+    return dev::HelpCache(dir / "help");
+}
+
+/// How long one `--help` run may take before it is killed (`[help]
+/// timeout` in seconds, 0 = no limit).
+static std::chrono::milliseconds help_timeout()
+{
+    auto t = config().get("help", "timeout");
+    if (t.empty())
+        return std::chrono::seconds(10);
+    return std::chrono::milliseconds(
+        static_cast<long long>(std::max(0.0, std::atof(t.c_str())) * 1000));
+}
+
+/// How to ask `name` for its help: a bundled plugin through dev itself,
+/// anything else through its plugin file (`path`, or resolved).
+static std::optional<dev::HelpJob> help_job(std::string_view name, dev::fs::path path = {})
+{
+    if (dev::find_bundled_plugin(name, config()))
+        return dev::HelpJob{dev::exe_path(g_argv0), {std::string(name), "--help"}};
+    if (path.empty())
+        path = dev::resolve_plugin(name, plugin_dirs());
+    if (path.empty())
+        return std::nullopt;
+    return dev::HelpJob{std::move(path), {"--help"}};
+}
+
+/// `dev help --refresh <cmd>...` (internal): re-capture and store the
+/// help of each command, concurrently.  Started by a stale cache hit.
+static int cmd_help_refresh(int argc, char* argv[])
+{
+    auto cache = help_cache();
+    std::vector<std::string_view> names;
+    std::vector<dev::HelpJob> jobs;
+    std::vector<dev::FileStamp> stamps;
+    for (int i = 3; i < argc; ++i) {
+        if (auto job = help_job(argv[i])) {
+            // Stamp before running: a change racing the capture shows up
+            // as stale next time instead of being lost.
+            stamps.push_back(dev::stamp_of(job->exe));
+            names.push_back(argv[i]);
+            jobs.push_back(std::move(*job));
+        }
+    }
+    auto texts = dev::capture_help(
+        jobs, std::max(4u, std::thread::hardware_concurrency()), help_timeout());
+    for (std::size_t k = 0; k < jobs.size(); ++k) {
+        if (texts[k] && dev::cacheable(*texts[k]))
+            cache.store(names[k], jobs[k].exe, stamps[k], *texts[k]);
+    }
+    return 0;
+}
+
+/// `dev help --all [-j N]`: every command's help — cached where fresh,
+/// the rest captured concurrently — printed in name order with one write().
+static int cmd_help_all(int argc, char* argv[])
+{
+#ifdef _WIN32
+    (void)argc;
+    (void)argv;
+    std::println(stderr,
+                 "{} dev help --all is not supported on Windows yet",
+                 s::red_text("error:"));
+    return static_cast<int>(dev::Error::InvalidUsage);
+#else
+    // Help runs mostly wait on interpreter / VM startup: oversubscribe a little.
+    std::size_t jobs = std::max(4u, std::thread::hardware_concurrency());
+    for (int i = 3; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "-j" && i + 1 < argc)
+            jobs = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (a.starts_with("-j") && a.size() > 2)
+            jobs = static_cast<std::size_t>(std::max(1, std::atoi(argv[i] + 2)));
+    }
+
+    auto index = open_index();
+    auto commands = list_commands(index);
+    auto cache = help_cache();
+
+    struct Row
+    {
+        std::string_view name;
+        dev::HelpJob job;
+        dev::FileStamp stamp;
+        dev::CachedHelp cached;
+        std::optional<dev::HelpText> captured;
+    };
+    std::vector<Row> rows;
+    std::vector<dev::HelpJob> misses;
+    std::vector<std::size_t> miss_rows;
+    std::vector<std::string> stale;
+    for (const auto& c : commands) {
+        auto entry = index.find(c.name);
+        auto job = help_job(c.name, entry ? dev::fs::path(entry->path) : dev::fs::path{});
+        if (!job)
+            continue;
+        auto stamp = dev::stamp_of(job->exe);
+        auto cached = cache.lookup(c.name, job->exe, stamp);
+        if (cached.state == dev::CachedHelp::State::Missing) {
+            miss_rows.push_back(rows.size());
+            misses.push_back(*job);
+        } else if (cached.state == dev::CachedHelp::State::Stale) {
+            stale.emplace_back(c.name);
+        }
+        rows.push_back({c.name, std::move(*job), stamp, std::move(cached), std::nullopt});
+    }
+
+    {
+        dev::trace::Span span("help capture", std::to_string(misses.size()));
+        auto texts = dev::capture_help(misses, jobs, help_timeout());
+        for (std::size_t k = 0; k < misses.size(); ++k) {
+            auto& row = rows[miss_rows[k]];
+            row.captured = std::move(texts[k]);
+            if (row.captured && dev::cacheable(*row.captured))
+                cache.store(row.name, row.job.exe, row.stamp, *row.captured);
+        }
+    }
+    if (!stale.empty())
+        dev::start_help_refresh(dev::exe_path(g_argv0), stale);
+    if (g_verbose) {
+        std::println(stderr,
+                     "{} help: {} cached, {} captured (-j {}), {} refreshing",
+                     s::dim_text("dev:"),
+                     rows.size() - misses.size(),
+                     misses.size(),
+                     jobs,
+                     stale.size());
+    }
+
+    dev::OutputBuffer out;
+    for (const auto& row : rows) {
+        out.println("{} {}", s::paint(s::bold, "──"), s::paint(s::cyan, row.name));
+        std::string_view text_out = row.captured ? row.captured->out : row.cached.out;
+        std::string_view text_err = row.captured ? row.captured->err : row.cached.err;
+        if (row.cached.state == dev::CachedHelp::State::Missing && !row.captured) {
+            out.println("{}", s::paint(s::dim, "(could not run)"));
+        } else if (row.captured && row.captured->timed_out) {
+            out.println("{}", s::paint(s::dim, "(timed out, output cut short)"));
+        }
+        for (auto text : {text_out, text_err}) {
+            out.print("{}", text);
+            if (!text.empty() && text.back() != '\n')
+                out.println();
+        }
+        out.println();
+    }
+    return 0;
+#endif
+}
+
 static int cmd_help(int argc, char* argv[])
 {
     if (argc < 3) {
-        std::println(stderr, "{} usage: dev help <command>", s::red_text("error:"));
+        std::println(stderr, "{} usage: dev help <command> | --all [-j N]", s::red_text("error:"));
         return static_cast<int>(dev::Error::InvalidUsage);
     }
 
     std::string_view target = argv[2];
-    auto plugin = dev::resolve_plugin(target, g_plugin_dirs);
+    if (target == "--all")
+        return cmd_help_all(argc, argv);
+    if (target == "--refresh")
+        return cmd_help_refresh(argc, argv);
+    if (const auto* bundled = dev::find_bundled_plugin(target, config())) {
+        const char* help_argv[] = {argv[2], "--help"};
+        return dev::run_bundled_plugin(*bundled, 2, const_cast<char**>(help_argv));
+    }
+    auto plugin = dev::resolve_plugin(target, plugin_dirs());
 
     if (plugin.empty()) {
-        std::println(stderr, "{} command '{}' not found", s::red_text("dev:"), target);
+        report_not_found(target);
         return static_cast<int>(dev::Error::CommandNotFound);
     }
 
+    // Cache hit: one read, one write.  A stale entry is still shown and
+    // refreshed in the background, so the next call is current.
+    auto cache = help_cache();
+    auto stamp = dev::stamp_of(plugin);
+    auto cached = cache.lookup(target, plugin, stamp);
+    if (cached.state != dev::CachedHelp::State::Missing) {
+        bool stale = cached.state == dev::CachedHelp::State::Stale;
+        if (stale)
+            dev::start_help_refresh(dev::exe_path(g_argv0), {std::string(target)});
+        if (g_verbose) {
+            std::println(stderr,
+                         "{} help cache {}",
+                         s::dim_text("dev:"),
+                         stale ? "stale (refreshing)" : "hit");
+        }
+        dev::write_help(cached.out, cached.err);
+        return cached.exit_code;
+    }
+
+    auto captured = dev::capture_help({dev::HelpJob{plugin, {"--help"}}}, 0, help_timeout());
+    if (captured[0] && captured[0]->timed_out) {
+        dev::write_help(captured[0]->out, captured[0]->err);
+        std::println(stderr,
+                     "{} '{} --help' timed out after {}s",
+                     s::yellow_text("dev:"),
+                     target,
+                     std::chrono::duration<double>(help_timeout()).count());
+        return 124; // like timeout(1)
+    }
+    if (captured[0]) {
+        if (dev::cacheable(*captured[0]))
+            cache.store(target, plugin, stamp, *captured[0]);
+        dev::write_help(captured[0]->out, captured[0]->err);
+        return captured[0]->exit_code;
+    }
+
+    // Not capturable (Windows, or no pipes): run it on the terminal.
     const char* help_argv[] = {argv[0], argv[2], "--help", nullptr};
+    if (dev::is_shared_plugin(plugin))
+        return dev::run_shared_plugin(plugin, 3, const_cast<char**>(help_argv));
     return dev::spawn(plugin, 3, const_cast<char**>(help_argv));
 }
 
-// ── Entry point ─────────────────────────────────────────────
+/// Consume a leading global flag.  Returns false if `a` is not one.
+static bool parse_global_flag(std::string_view a)
+{
+    if (a == "--verbose" || a == "-V" || a == "--quiet" || a == "-q")
+        return true; // already handled by the pre-scan
+    if (a == "--exec") {
+        g_exec = 1;
+        return true;
+    }
+    if (a == "--no-exec") {
+        g_exec = 0;
+        return true;
+    }
+    if (a == "--time" || a == "--time=text") {
+        g_time = TimeMode::Text;
+        return true;
+    }
+    if (a == "--time=json") {
+        g_time = TimeMode::Json;
+        return true;
+    }
+    if (a == "--no-time") {
+        g_time = TimeMode::Off;
+        return true;
+    }
+    if (a.starts_with("--trace=")) {
+        // Opened right away so every later phase lands in the trace.
+        std::string file(a.substr(8));
+        if (file.empty() || !dev::trace::open(file)) {
+            std::println(stderr, "{} cannot open trace file '{}'", s::yellow_text("dev:"), file);
+        }
+        return true;
+    }
+    return false;
+}
 
-int main(int argc, char* argv[])
+/// One `<cmd> [args]` group of a `dev par` / `dev pipe` command line.
+struct CommandLine
 {
-    s::init();
-    load_config(argv[0]);
+    std::string name;
+    std::vector<std::string> args;
+};
 
-    // ── Pre-scan for global flags ───────────────────────────
-    for (int i = 1; i < argc; ++i) {
+/// Split argv[i..] into commands separated by `--`.
+static std::vector<CommandLine> split_commands(int i, int argc, char* argv[])
+{
+    std::vector<CommandLine> out;
+    for (; i < argc; ++i) {
         std::string_view a = argv[i];
-        if (a == "--verbose" || a == "-V")
-            g_verbose = true;
-        if (a == "--quiet" || a == "-q")
-            g_quiet = true;
+        if (a == "--") {
+            continue;
+        }
+        if (out.empty() || std::string_view(argv[i - 1]) == "--") {
+            out.push_back({std::string(a), {}});
+        } else {
+            out.back().args.emplace_back(a);
+        }
     }
+    return out;
+}
 
-    if (argc < 2) {
-        print_usage();
+/// Resolve a command (through aliases) to a plugin executable; prints the
+/// error and returns its exit code if that is not possible.  A bundled
+/// plugin resolves to dev itself, with the command prepended to `args`.
+static int resolve_command(const std::string& name,
+                           dev::fs::path& exe,
+                           std::vector<std::string>& args,
+                           std::string* plugin = nullptr)
+{
+    std::string command = name;
+    if (auto target = config().get("alias", command); !target.empty())
+        command = std::move(target);
+    if (dev::is_builtin(command)) {
+        std::println(stderr, "{} '{}' is a built-in, not a plugin", s::red_text("dev:"), command);
+        return static_cast<int>(dev::Error::InvalidUsage);
+    }
+    if (dev::find_bundled_plugin(command, config())) {
+        exe = dev::exe_path(g_argv0);
+        args.insert(args.begin(), command);
+        if (plugin)
+            *plugin = std::move(command);
         return 0;
     }
+    exe = dev::resolve_plugin(command, plugin_dirs());
+    if (exe.empty()) {
+        report_not_found(command);
+        return static_cast<int>(dev::Error::CommandNotFound);
+    }
+    if (plugin)
+        *plugin = std::move(command);
+    return 0;
+}
 
-    std::string command_str(argv[1]);
+/// `dev par [-j N] [--group] [--fail-fast] <cmd> [args] -- <cmd> [args] ...`
+static int cmd_par(int argc, char* argv[])
+{
+    dev::ParallelOptions opts;
+    opts.quiet = g_quiet;
+    opts.group = config().get_bool("par", "group");
+    if (auto jobs = config().get("par", "jobs"); !jobs.empty())
+        opts.jobs = static_cast<std::size_t>(std::max(0, std::atoi(jobs.c_str())));
+
+    int i = 2;
+    for (; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if ((a == "-j" || a == "--jobs") && i + 1 < argc) {
+            opts.jobs = static_cast<std::size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (a.starts_with("-j") && a.size() > 2) {
+            opts.jobs = static_cast<std::size_t>(std::max(0, std::atoi(argv[i] + 2)));
+        } else if (a == "--group") {
+            opts.group = true;
+        } else if (a == "--fail-fast") {
+            opts.fail_fast = true;
+        } else {
+            break;
+        }
+    }
 
-    // Skip if first arg is a global flag
-    if (command_str == "--verbose" || command_str == "-V" || command_str == "--quiet" ||
-        command_str == "-q") {
-        if (argc < 3) {
-            print_usage();
+    auto commands = split_commands(i, argc, argv);
+    if (commands.empty()) {
+        std::println(stderr,
+                     "{} usage: dev par [-j N] [--group] [--fail-fast] <cmd> [args] -- <cmd> ...",
+                     s::red_text("error:"));
+        return static_cast<int>(dev::Error::InvalidUsage);
+    }
+
+    std::vector<dev::ParallelJob> jobs;
+    for (auto& c : commands) {
+        dev::ParallelJob job{std::move(c.name), {}, std::move(c.args)};
+        if (int rc = resolve_command(job.name, job.exe, job.args); rc != 0)
+            return rc;
+        jobs.push_back(std::move(job));
+    }
+
+    select_spawn_backend();
+    opts.jobserver = jobserver();
+    return dev::run_parallel(jobs, opts);
+}
+
+/// "64K", "1M", "1048576" → bytes; 0 if malformed.
+static std::size_t parse_size(std::string_view text)
+{
+    std::size_t value = 0;
+    std::size_t i = 0;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i)
+        value = value * 10 + static_cast<std::size_t>(text[i] - '0');
+    auto suffix = text.substr(i);
+    if (suffix.empty())
+        return value;
+    if (suffix == "K" || suffix == "k")
+        return value << 10;
+    if (suffix == "M" || suffix == "m")
+        return value << 20;
+    return 0;
+}
+
+/// `dev pipe [--buffer=SIZE] [--tap=N:FILE] <cmd> [args] -- <cmd> [args] ...`
+static int cmd_pipe(int argc, char* argv[])
+{
+    dev::PipelineOptions opts;
+    if (auto size = config().get("pipe", "buffer"); !size.empty())
+        opts.raw_pipe_size = parse_size(size);
+
+    int i = 2;
+    for (; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a.starts_with("--buffer=")) {
+            opts.raw_pipe_size = parse_size(a.substr(9));
+        } else if (a.starts_with("--tap=") && a.find(':') != std::string_view::npos) {
+            auto spec = a.substr(6);
+            auto colon = spec.find(':');
+            opts.tap_stage = std::atoi(std::string(spec.substr(0, colon)).c_str()) - 1;
+            opts.tap_file = spec.substr(colon + 1);
+        } else {
+            break;
+        }
+    }
+
+    auto commands = split_commands(i, argc, argv);
+    if (commands.size() < 2) {
+        std::println(stderr,
+                     "{} usage: dev pipe [--buffer=SIZE] [--tap=N:FILE] <cmd> [args] -- <cmd> ...",
+                     s::red_text("error:"));
+        return static_cast<int>(dev::Error::InvalidUsage);
+    }
+    if (opts.tap_stage >= 0 && static_cast<std::size_t>(opts.tap_stage) + 1 >= commands.size()) {
+        std::println(stderr,
+                     "{} --tap needs a stage that feeds another (1..{})",
+                     s::red_text("error:"),
+                     commands.size() - 1);
+        return static_cast<int>(dev::Error::InvalidUsage);
+    }
+
+    dev::Config meta;
+    if (!meta_path().empty())
+        meta = dev::Config::load(meta_path());
+
+    std::vector<dev::PipelineStage> stages;
+    for (auto& c : commands) {
+        dev::PipelineStage stage{std::move(c.name), {}, std::move(c.args)};
+        std::string plugin;
+        if (int rc = resolve_command(stage.name, stage.exe, stage.args, &plugin); rc != 0)
+            return rc;
+        // plugins.toml first, then the plugin's own DEV_PLUGIN_META flags.
+        if (auto stream = meta.get(plugin, "stream"); !stream.empty())
+            stage.raw = stream == "raw";
+        else if (!dev::find_bundled_plugin(plugin, config()))
+            stage.raw = dev::read_plugin_meta(stage.exe)
+                            .value_or(dev::PluginMeta{})
+                            .has_flag("raw");
+        stages.push_back(std::move(stage));
+    }
+
+#ifdef _WIN32
+    std::println(stderr, "{} dev pipe is not supported on Windows yet", s::red_text("error:"));
+    return static_cast<int>(dev::Error::InvalidUsage);
+#else
+    select_spawn_backend();
+    jobserver(); // exported to every stage, like any dispatch
+    std::vector<int> statuses;
+    int rc = dev::run_pipeline(stages, opts, &statuses);
+    if (g_verbose) {
+        for (std::size_t k = 0; k < stages.size(); ++k) {
+            std::println(stderr, "{} {} → {}", s::dim_text("dev:"), stages[k].name, statuses[k]);
+        }
+    }
+    return rc;
+#endif
+}
+
+/// `dev task [-j N] [--force] [--dry-run] <name>...`; no names lists the tasks.
+static int cmd_task(int argc, char* argv[])
+{
+    auto tasks = dev::load_tasks(config());
+
+    dev::TaskOptions opts;
+    opts.quiet = g_quiet;
+    if (auto jobs = config().get("task", "jobs"); !jobs.empty())
+        opts.jobs = static_cast<std::size_t>(std::max(0, std::atoi(jobs.c_str())));
+
+    std::vector<std::string> targets;
+    for (int i = 2; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if ((a == "-j" || a == "--jobs") && i + 1 < argc) {
+            opts.jobs = static_cast<std::size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (a.starts_with("-j") && a.size() > 2) {
+            opts.jobs = static_cast<std::size_t>(std::max(0, std::atoi(argv[i] + 2)));
+        } else if (a == "--force" || a == "-f") {
+            opts.force = true;
+        } else if (a == "--dry-run" || a == "-n") {
+            opts.dry_run = true;
+        } else if (a == "-q" || a == "--quiet" || a == "-V" || a == "--verbose") {
+            // already applied by the global pre-scan
+        } else if (a.starts_with('-')) {
+            std::println(stderr,
+                         "{} usage: dev task [-j N] [--force] [--dry-run] <name>...",
+                         s::red_text("error:"));
+            return static_cast<int>(dev::Error::InvalidUsage);
+        } else {
+            targets.emplace_back(a);
+        }
+    }
+
+    if (targets.empty()) {
+        if (tasks.empty()) {
+            std::println("No tasks defined (add [tasks.<name>] sections to dev.toml).");
             return 0;
         }
-        command_str = argv[2];
-        // Shift argv for dispatch
-        argv[1] = argv[2];
-        for (int i = 3; i < argc; ++i)
-            argv[i - 1] = argv[i];
-        --argc;
+        if (!g_quiet) {
+            std::println("{}", s::bold_text("Tasks:"));
+            std::println("");
+        }
+        for (const auto& t : tasks) {
+            std::string deps;
+            for (const auto& d : t.deps)
+                deps += (deps.empty() ? "← " : ", ") + d;
+            if (deps.empty())
+                std::println("  {}", s::cyan_text(t.name));
+            else
+                std::println("  {:<22} {}", s::cyan_text(t.name), s::dim_text(deps));
+        }
+        return 0;
+    }
+
+    // Task paths are relative to dev.toml; chdir once rather than per
+    // spawn (start() changes the process-wide cwd on Windows).
+    std::error_code ec;
+    auto root = config().path().empty() ? dev::fs::current_path(ec)
+                                        : dev::fs::absolute(config().path(), ec).parent_path();
+    dev::fs::current_path(root, ec);
+    opts.state_file = root / ".dev" / "tasks.state";
+
+    select_spawn_backend();
+    // Tokens bound the tasks actually running; a created jobserver also
+    // sizes the pool, an inherited one leaves it at the default.
+    opts.jobserver = jobserver();
+    if (opts.jobserver && opts.jobserver->slots() && !opts.jobs)
+        opts.jobs = opts.jobserver->slots();
+    if (g_verbose) {
+        std::println(stderr, "{} tasks in {}", s::dim_text("dev:"), root.string());
     }
+    return dev::run_tasks(tasks, targets, opts);
+}
+
+static int cmd_daemon(int argc, char* argv[])
+{
+    std::string_view op = (argc >= 3) ? argv[2] : "status";
+    if (op == "start")
+        return dev::daemon::start(g_argv0, false);
+    if (op == "run")
+        return dev::daemon::start(g_argv0, true);
+    if (op == "stop")
+        return dev::daemon::stop();
+    if (op == "status")
+        return dev::daemon::status();
+
+    std::println(stderr, "{} usage: dev daemon <start|stop|status|run>", s::red_text("error:"));
+    return static_cast<int>(dev::Error::InvalidUsage);
+}
+
+static int command_not_found(int argc, char* argv[]);
+
+/// Run `argv[1]` once global flags are stripped: alias, built-in,
+/// bundled plugin, or plugin dir.
+static int run_command(int argc, char* argv[])
+{
+    std::string command_str(argv[1]);
 
     // ── Resolve alias ───────────────────────────────────────
-    if (auto it = g_aliases.find(command_str); it != g_aliases.end()) {
-        if (g_verbose) {
-            std::println("{} alias '{}' → '{}'", s::dim_text("dev:"), command_str, it->second);
+    {
+        const auto& cfg = config(); // loaded outside the alias span
+        dev::trace::Span span("alias", command_str);
+        if (auto target = cfg.get("alias", command_str); !target.empty()) {
+            if (g_verbose) {
+                std::println("{} alias '{}' → '{}'", s::dim_text("dev:"), command_str, target);
+            }
+            command_str = std::move(target);
+            argv[1] = command_str.data();
         }
-        command_str = it->second;
-        argv[1] = command_str.data();
     }
 
     std::string_view command = command_str;
@@ -217,14 +973,332 @@ int main(int argc, char* argv[])
         return cmd_list();
     if (command == "help")
         return cmd_help(argc, argv);
+    if (command == "daemon")
+        return cmd_daemon(argc, argv);
+    if (command == "par")
+        return cmd_par(argc, argv);
+    if (command == "pipe")
+        return cmd_pipe(argc, argv);
+    if (command == "task")
+        return cmd_task(argc, argv);
 
     // ── Plugin dispatch ─────────────────────────────────────
-    if (g_verbose) {
-        auto plugin = dev::resolve_plugin(command, g_plugin_dirs);
+    select_spawn_backend();
+    jobserver(); // advertised through MAKEFLAGS before the plugin starts
+
+    const auto* bundled = dev::find_bundled_plugin(command, config());
+
+    if (g_verbose && bundled) {
+        std::println("{} running bundled {} (in-process)", s::dim_text("dev:"), command);
+    } else if (g_verbose) {
+        auto plugin = dev::resolve_plugin(command, plugin_dirs());
         if (!plugin.empty()) {
-            std::println("{} dispatching to {}", s::dim_text("dev:"), plugin.string());
+            std::println("{} dispatching to {} ({})",
+                         s::dim_text("dev:"),
+                         plugin.string(),
+                         dev::is_shared_plugin(plugin)
+                             ? "in-process"
+                             : dev::spawn_backend_name(dev::g_spawn_backend));
+        }
+    }
+
+    auto hooks = dev::load_hooks(config(), command);
+
+    dev::DispatchOptions opts;
+    opts.exec = (g_exec < 0) ? config().get_bool("dispatch", "exec") : (g_exec == 1);
+    opts.isolate = config().get_bool("plugins", "isolate");
+    opts.hooks = &hooks;
+    opts.not_found = command_not_found;
+
+    auto mode = time_mode();
+    dev::ResourceUsage usage;
+    if (mode != TimeMode::Off)
+        opts.usage = &usage;
+
+    int rc = 0;
+    if (bundled) {
+        if (rc = dev::run_pre_hooks(hooks, command); rc != 0)
+            return rc;
+        // argv[1] (the command) becomes the bundled plugin's argv[0].
+        rc = dev::run_bundled_plugin(*bundled, argc - 1, argv + 1, opts.isolate, opts.usage);
+        dev::run_post_hooks(hooks, command, rc);
+    } else {
+        rc = dev::dispatch(argc, argv, plugin_dirs(), opts);
+    }
+    if (opts.usage && usage.wall_s > 0) // a plugin actually ran
+        report_usage(command, rc, usage, mode == TimeMode::Json);
+    return rc;
+}
+
+/// dispatch()'s not-found handler: the error with suggestions, or — with
+/// `[dispatch] autocorrect = true` — the single command one edit away.
+static int command_not_found(int argc, char* argv[])
+{
+    static bool corrected = false; // at most once: the index may be stale
+    std::string_view command = argv[1];
+    auto index = open_index();
+    auto names = command_names(index);
+    auto suggestions = dev::suggest(command, names);
+
+    if (const auto* fix = dev::unique_correction(suggestions);
+        fix && !corrected && config().get_bool("dispatch", "autocorrect")) {
+        corrected = true;
+        std::println(stderr,
+                     "{} command '{}' not found, running '{}'",
+                     s::yellow_text("dev:"),
+                     command,
+                     fix->name);
+        std::string target(fix->name);
+        argv[1] = target.data();
+        return run_command(argc, argv);
+    }
+
+    std::println(stderr, "{} command '{}' not found", s::red_text("dev:"), command);
+    print_suggestions(suggestions);
+    std::println(stderr, "  searched in:");
+    for (const auto& d : plugin_dirs())
+        std::println(stderr, "    {}", d.string());
+    return static_cast<int>(dev::Error::CommandNotFound);
+}
+
+// ── Completion ──────────────────────────────────────────────
+
+struct FlagInfo
+{
+    std::string_view flag;
+    std::string_view description;
+};
+
+/// Global flags offered at the command position.
+static constexpr FlagInfo global_flags[] = {
+    {"--help", "Show help"},
+    {"--version", "Show version"},
+    {"--quiet", "Suppress non-essential output"},
+    {"--verbose", "Extra detail"},
+    {"--exec", "Replace dev with the plugin"},
+    {"--no-exec", "Always fork and wait"},
+    {"--time", "CPU/memory/faults summary"},
+    {"--time=json", "Resource summary as JSON"},
+    {"--no-time", "No resource summary"},
+    {"--trace=", "Write a Chrome trace of dispatch phases"},
+};
+
+/// Built-in commands with their completion specs (see dev/complete.hpp).
+struct BuiltinInfo
+{
+    std::string_view name;
+    std::string_view description;
+    std::string_view spec;
+};
+
+static constexpr BuiltinInfo builtin_infos[] = {
+    {"list", "List available commands", ""},
+    {"help", "Show help for a command", "--all"},
+    {"daemon", "Resident dispatcher", "start stop status run"},
+    {"par", "Run commands concurrently", "-j --group --fail-fast"},
+    {"pipe", "Pipe commands stdout to stdin", "--buffer --tap"},
+    {"task", "Run dev.toml tasks", "-j --force --dry-run"},
+};
+
+/// A global flag as stripped by main() (checked without side effects).
+static bool is_global_flag(std::string_view a)
+{
+    for (const auto& f : global_flags) {
+        if (a == f.flag && a != "--help" && a != "--version")
+            return true;
+    }
+    return a == "-V" || a == "-q" || a == "--time=text" || a.starts_with("--trace=");
+}
+
+/// Completes with what `dev __complete` needs, opening the plugin index
+/// and plugins.toml only when a candidate list asks for them.
+class CommandCompleter
+{
+public:
+    explicit CommandCompleter(dev::Completions& out)
+        : out_(out)
+    {
+    }
+
+    /// Everything `dev <name>` runs: plugins (a prefix range of the
+    /// index), bundled plugins, aliases and built-ins.
+    void commands()
+    {
+        auto prefix = out_.current();
+        const auto& idx = index();
+        for (auto i = idx.lower_bound(prefix); i < idx.size(); ++i) {
+            auto e = idx[i];
+            if (!e.name.starts_with(prefix))
+                break;
+            out_.add(e.name, e.description);
+        }
+        for (const auto& b : dev::bundled_plugins()) {
+            if (b.name.starts_with(prefix) && dev::find_bundled_plugin(b.name, config())) {
+                const char* desc = b.entry()->description;
+                out_.add(b.name, desc ? desc : "");
+            }
+        }
+        for (const auto& e : config().section("alias")) {
+            if (!e.is_list)
+                out_.add(e.key, e.value);
+        }
+        for (const auto& b : builtin_infos)
+            out_.add(b.name, b.description);
+    }
+
+    /// Arguments of a plugin, from its completion spec.
+    void plugin_args(std::string_view name, std::string_view previous)
+    {
+        if (auto target = config().value("alias", name); target && !target->empty())
+            name = *target;
+        dev::complete_spec(plugin_spec(name), previous, out_);
+    }
+
+private:
+    dev::Completions& out_;
+    std::optional<dev::PluginIndex> index_;
+    std::optional<dev::Config> meta_;
+
+    const dev::PluginIndex& index()
+    {
+        if (!index_)
+            index_ = open_index();
+        return *index_;
+    }
+
+    std::string_view plugin_spec(std::string_view name)
+    {
+        if (!dev::find_bundled_plugin(name, config())) {
+            auto e = index().find(name);
+            return e ? e->completion : std::string_view{};
+        }
+        // Built into dev: no file to carry a note, only plugins.toml.
+        if (!meta_)
+            meta_ = meta_path().empty() ? dev::Config{} : dev::Config::load(meta_path());
+        return meta_->value(name, "completion").value_or(std::string_view{});
+    }
+};
+
+/// `dev __complete <cword> <words...>` (internal): completion candidates
+/// for the scripts of `dev completion`, one per line, in a single write().
+static int cmd_complete(int argc, char* argv[])
+{
+    if (argc < 3)
+        return static_cast<int>(dev::Error::InvalidUsage);
+    auto cword = static_cast<std::size_t>(std::max(0, std::atoi(argv[2])));
+    std::vector<std::string_view> words(argv + 3, argv + argc);
+    auto word = [&](std::size_t i) { return i < words.size() ? words[i] : std::string_view{}; };
+
+    dev::Completions out(word(cword));
+    CommandCompleter complete(out);
+    std::string_view previous = cword > 0 ? word(cword - 1) : std::string_view{};
+
+    // words[0] is dev; the command follows the global flags.
+    std::size_t cmd = 1;
+    while (cmd < cword && is_global_flag(word(cmd)))
+        ++cmd;
+
+    const BuiltinInfo* builtin = nullptr;
+    for (const auto& b : builtin_infos) {
+        if (b.name == word(cmd))
+            builtin = &b;
+    }
+
+    if (cword <= cmd) {
+        if (out.current().starts_with('-')) {
+            for (const auto& f : global_flags)
+                out.add(f.flag, f.description);
+        } else {
+            complete.commands();
+        }
+    } else if (!builtin) {
+        complete.plugin_args(word(cmd), previous);
+    } else if (builtin->name == "help") {
+        if (cword == cmd + 1) {
+            complete.commands();
+            dev::complete_spec(builtin->spec, previous, out);
+        }
+    } else if (builtin->name == "par" || builtin->name == "pipe") {
+        // The command under the cursor starts after the last `--`, or
+        // after the built-in's own options.
+        std::size_t start = cmd + 1;
+        bool separated = false;
+        for (std::size_t k = cmd + 1; k < cword; ++k) {
+            if (word(k) == "--") {
+                start = k + 1;
+                separated = true;
+            }
         }
+        while (!separated && start < cword && word(start).starts_with('-'))
+            start += word(start) == "-j" ? 2 : 1;
+        if (cword == start && !separated && out.current().starts_with('-'))
+            dev::complete_spec(builtin->spec, previous, out);
+        else if (cword == start)
+            complete.commands();
+        else if (cword > start)
+            complete.plugin_args(word(start), previous);
+    } else if (builtin->name == "task" && !out.current().starts_with('-')) {
+        for (const auto& t : dev::load_tasks(config()))
+            out.add(t.name);
+    } else {
+        dev::complete_spec(builtin->spec, previous, out);
+    }
+
+    dev::OutputBuffer buf;
+    out.write(buf);
+    return 0;
+}
+
+// ── Entry point ─────────────────────────────────────────────
+
+int main(int argc, char* argv[])
+{
+    g_argv0 = argv[0];
+
+    // Runs on every TAB: before flag parsing, colours and the daemon.
+    if (argc >= 2 && std::string_view(argv[1]) == "__complete")
+        return cmd_complete(argc, argv);
+
+    // ── Pre-scan for global flags ───────────────────────────
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--verbose" || a == "-V")
+            g_verbose = true;
+        if (a == "--quiet" || a == "-q")
+            g_quiet = true;
     }
 
-    return dev::dispatch(argc, argv, g_plugin_dirs);
-}
\ No newline at end of file
+    // Strip leading global flags, shifting argv for dispatch
+    while (argc >= 2 && parse_global_flag(argv[1])) {
+        for (int i = 2; i < argc; ++i)
+            argv[i - 1] = argv[i];
+        --argc;
+    }
+
+    // ── Version: needs no config, colors, or filesystem ─────
+    if (argc >= 2) {
+        std::string_view first = argv[1];
+        if (first == "--version" || first == "-v") {
+            std::println("dev v{}", dev::version);
+            return 0;
+        }
+    }
+
+    // ── Resident daemon: skips config + resolution entirely ─
+    // Not while tracing or timing: dev must be the plugin's parent for those.
+    if (argc >= 2 && g_exec != 1 && !dev::trace::enabled() &&
+        (g_time == TimeMode::Config || g_time == TimeMode::Off) && !dev::is_builtin(argv[1]) &&
+        !dev::find_bundled_plugin(argv[1])) {
+        if (auto rc = dev::daemon::try_dispatch(argc, argv))
+            return *rc;
+    }
+
+    s::init();
+
+    if (argc < 2) {
+        print_usage();
+        return 0;
+    }
+
+    return run_command(argc, argv);
+}
@@ -0,0 +1,237 @@
+/**
+ * @file config_image.cpp
+ * @brief Unit test: Config round trip through the compiled image (`dev_test_config_image`).
+ *
+ * Writes a config above Config::compile_threshold, loads it through the
+ * cache (which compiles the image) and again (which attaches it), and
+ * checks every lookup against a plain text parse.  Then damages the image
+ * in the ways attach() must catch — truncation, a foreign header, string
+ * offsets and slots out of bounds, a stale source — and checks that each
+ * load falls back to the text, answers the same, and rewrites the image.
+ *
+ * Exit code: 0 ok, 1 a check failed.
+ */
+
+#include "dev/config.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <print>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int g_failures = 0;
+
+static void
+check(bool ok, std::string_view what, std::source_location at = std::source_location::current())
+{
+    if (!ok) {
+        std::println(stderr, "{}:{}: check failed: {}", at.file_name(), at.line(), what);
+        ++g_failures;
+    }
+}
+
+// ── Fixture ─────────────────────────────────────────────────
+
+struct Key
+{
+    std::string section;
+    std::string key;
+};
+
+struct Fixture
+{
+    fs::path root;
+    fs::path toml;
+    std::vector<Key> scalars;
+    std::vector<Key> lists;
+
+    Fixture()
+    {
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::error_code ec;
+        root = fs::temp_directory_path(ec) / ("dev-test-config-" + std::to_string(stamp));
+        fs::create_directories(root, ec);
+
+        // Images go to the fixture, not the user's cache.
+        auto cache = (root / "cache").string();
+#ifdef _WIN32
+        _putenv_s("DEV_CACHE_DIR", cache.c_str());
+#else
+        setenv("DEV_CACHE_DIR", cache.c_str(), 1);
+#endif
+
+        toml = root / "dev.toml";
+        std::ofstream out(toml);
+        out << "# generated by config_image.cpp\n[alias]\n";
+        for (int i = 0; i < 600; ++i) {
+            out << "a" << i << " = \"command-" << i << "\"\n";
+            scalars.push_back({"alias", "a" + std::to_string(i)});
+        }
+        for (int s = 0; s < 20; ++s) {
+            auto section = "tasks.t" + std::to_string(s);
+            out << "\n[" << section << "]\n";
+            out << "cmd = \"make target-" << s << "\"  # trailing comment\n";
+            out << "deps = [\"t" << (s + 1) % 20 << "\", \"t" << (s + 2) % 20 << "\"]\n";
+            out << "inputs = []\n";
+            scalars.push_back({section, "cmd"});
+            lists.push_back({section, "deps"});
+            lists.push_back({section, "inputs"});
+        }
+        out << "\n[plugins]\ndirs = [\"~/.dev/plugins\", \"/opt/dev/plugins\"]\n";
+        out << "[dispatch]\nexec = true\n";
+        scalars.push_back({"dispatch", "exec"});
+        lists.push_back({"plugins", "dirs"});
+    }
+
+    ~Fixture()
+    {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    /// The single image in the cache dir (empty if there is none).
+    [[nodiscard]] fs::path image() const
+    {
+        std::error_code ec;
+        for (const auto& e : fs::directory_iterator(root / "cache", ec)) {
+            if (e.path().filename().string().starts_with("config-")) {
+                return e.path();
+            }
+        }
+        return {};
+    }
+};
+
+static std::string read_file(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+static void write_file(const fs::path& path, std::string_view data)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        .write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+/// Every lookup of `got` answers like the text parse `want`.
+static void check_same(const dev::Config& got, const dev::Config& want, const Fixture& fx)
+{
+    for (const auto& k : fx.scalars) {
+        check(got.get(k.section, k.key) == want.get(k.section, k.key), k.section + "." + k.key);
+    }
+    for (const auto& k : fx.lists) {
+        check(got.get_list(k.section, k.key) == want.get_list(k.section, k.key),
+              k.section + "." + k.key + " (list)");
+    }
+    check(!got.value("alias", "no-such-alias"), "miss in a known section");
+    check(!got.value("no-such-section", "a0"), "miss in an unknown section");
+    check(got.get_section("alias") == want.get_section("alias"), "get_section(alias)");
+    check(got.subsections("tasks") == want.subsections("tasks"), "subsections(tasks)");
+}
+
+// ── Image layout (CompiledHeader in dev/config.hpp) ─────────
+
+constexpr std::size_t header_size = 72;
+constexpr std::size_t version_at = 8;
+constexpr std::size_t slot_count_at = 28;
+constexpr std::size_t text_size_at = 64;
+
+static std::uint64_t load_u64(const std::string& image, std::size_t at)
+{
+    std::uint64_t v = 0;
+    std::memcpy(&v, image.data() + at, sizeof v);
+    return v;
+}
+
+static void store_u32(std::string& image, std::size_t at, std::uint32_t v)
+{
+    std::memcpy(image.data() + at, &v, sizeof v);
+}
+
+// ── Tests ───────────────────────────────────────────────────
+
+int main()
+{
+    Fixture fx;
+    const auto text = dev::Config::load(fx.toml, false);
+    check(fs::file_size(fx.toml) >= dev::Config::compile_threshold,
+          "fixture is large enough to be compiled");
+    check(!text.empty() && !text.from_cache(), "text parse");
+
+    auto first = dev::Config::load(fx.toml);
+    check(!first.from_cache(), "first load parses");
+    auto image = fx.image();
+    check(!image.empty(), "first load writes the image");
+    if (image.empty()) {
+        return 1;
+    }
+    check_same(first, text, fx);
+
+    auto second = dev::Config::load(fx.toml);
+    check(second.from_cache(), "second load attaches the image");
+    check_same(second, text, fx);
+
+    const std::string good = read_file(image);
+    check(good.size() > header_size, "image has a header");
+    auto text_at = good.size() - load_u64(good, text_size_at);
+    std::uint32_t slot_count = 0;
+    std::memcpy(&slot_count, good.data() + slot_count_at, sizeof slot_count);
+
+    struct Damage
+    {
+        std::string_view name;
+        std::function<void(std::string&)> apply;
+    };
+    const std::vector<Damage> damages = {
+        {"empty", [](std::string& b) { b.clear(); }},
+        {"cut inside the header", [](std::string& b) { b.resize(16); }},
+        {"last byte missing", [](std::string& b) { b.pop_back(); }},
+        {"trailing garbage", [](std::string& b) { b += "x"; }},
+        {"foreign magic", [](std::string& b) { b[0] = 'X'; }},
+        {"other version", [](std::string& b) { store_u32(b, version_at, 0xffff); }},
+        {"string offset out of bounds",
+         [](std::string& b) { store_u32(b, header_size, 0xffff'0000); }},
+        {"slot out of bounds",
+         [&](std::string& b) {
+             store_u32(b, text_at - std::size_t{slot_count} * 4, 0xffff'ffff);
+         }},
+    };
+    for (const auto& d : damages) {
+        auto bytes = good;
+        d.apply(bytes);
+        write_file(image, bytes);
+
+        auto damaged = dev::Config::load(fx.toml);
+        check(!damaged.from_cache(), std::string(d.name) + ": rejected");
+        check_same(damaged, text, fx);
+        check(read_file(image) == good, std::string(d.name) + ": rewritten");
+        check(dev::Config::load(fx.toml).from_cache(), std::string(d.name) + ": attached again");
+    }
+
+    // A changed source invalidates the image through its stamp.
+    std::ofstream(fx.toml, std::ios::app) << "[late]\nkey = added\n";
+    auto changed = dev::Config::load(fx.toml);
+    check(!changed.from_cache(), "stale image: rejected");
+    check(changed.get("late", "key") == "added", "stale image: new key visible");
+    check(dev::Config::load(fx.toml).from_cache(), "stale image: replaced");
+
+    if (g_failures != 0) {
+        std::println(stderr, "{} check(s) failed", g_failures);
+        return 1;
+    }
+    std::println("config image: ok");
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file globs.cpp
+ * @brief Unit test: `dev task` glob semantics (`dev_test_globs`).
+ *
+ * Checks what dev/tasks.hpp promises for `inputs` / `outputs` patterns:
+ * `*` and `?` stay inside one path component, `**` spans any number of
+ * them (`**` + `/` only at component boundaries), a pattern without
+ * wildcards names a file or a whole directory, dot-directories are not
+ * descended into, and expand_globs() returns sorted, deduplicated paths.
+ *
+ * Exit code: 0 ok, 1 a check failed.
+ */
+
+#include "dev/tasks.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int g_failures = 0;
+
+static void
+check(bool ok, std::string_view what, std::source_location at = std::source_location::current())
+{
+    if (!ok) {
+        std::println(stderr, "{}:{}: check failed: {}", at.file_name(), at.line(), what);
+        ++g_failures;
+    }
+}
+
+// ── glob_match ──────────────────────────────────────────────
+
+struct MatchCase
+{
+    std::string_view pattern;
+    std::string_view path;
+    bool match;
+};
+
+constexpr MatchCase match_cases[] = {
+    // Literal
+    {"a.txt", "a.txt", true},
+    {"a.txt", "a.txt.bak", false},
+    {"a.txt", "dir/a.txt", false},
+    // `*` within one component
+    {"*.cpp", "main.cpp", true},
+    {"*.cpp", "src/main.cpp", false},
+    {"src/*.cpp", "src/main.cpp", true},
+    {"src/*.cpp", "src/util/x.cpp", false},
+    {"src/*", "src/util/x.cpp", false},
+    {"*/x.cpp", "util/x.cpp", true},
+    {"a*b*c", "aXbYc", true},
+    {"a*b*c", "aX/bYc", false},
+    // `?` is one character, never `/`
+    {"a?c", "abc", true},
+    {"a?c", "ac", false},
+    {"a?c", "a/c", false},
+    {"src/?.hpp", "src/x.hpp", true},
+    // `**` spans components
+    {"**", "a", true},
+    {"**", "a/b/c", true},
+    {"src/**", "src/a/b.cpp", true},
+    {"src/**", "srcx/a.cpp", false},
+    {"**/*.cpp", "main.cpp", true},
+    {"**/*.cpp", "a/b/main.cpp", true},
+    {"**/*.cpp", "a/b/main.hpp", false},
+    {"src/**/*.hpp", "src/x.hpp", true},
+    {"src/**/*.hpp", "src/a/b/x.hpp", true},
+    {"src/**/*.hpp", "srcx/x.hpp", false},
+    {"src/**/*.hpp", "lib/src/x.hpp", false},
+    // `**/` resumes only at a component boundary; `**x` anywhere
+    {"**/b.txt", "a/b.txt", true},
+    {"**/b.txt", "ab.txt", false},
+    {"**.txt", "a/b.txt", true},
+    {"**b.txt", "ab.txt", true},
+};
+
+// ── expand_globs ────────────────────────────────────────────
+
+struct Tree
+{
+    fs::path root;
+
+    Tree()
+    {
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::error_code ec;
+        root = fs::temp_directory_path(ec) / ("dev-test-globs-" + std::to_string(stamp));
+        for (auto rel : {"a.txt",
+                         "b.md",
+                         ".env",
+                         "src/main.cpp",
+                         "src/util/x.cpp",
+                         "src/util/x.hpp",
+                         "src/.cache/y.cpp",
+                         ".git/config",
+                         "docs/guide/intro.md"}) {
+            auto path = root / rel;
+            fs::create_directories(path.parent_path(), ec);
+            std::ofstream(path) << rel << '\n';
+        }
+        fs::create_directories(root / "empty", ec);
+    }
+
+    ~Tree()
+    {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+};
+
+using Files = std::vector<std::string>;
+
+static std::string show(const Files& files)
+{
+    std::string out = "[";
+    for (const auto& f : files) {
+        out += (out.size() > 1 ? ", " : "") + f;
+    }
+    return out + "]";
+}
+
+int main()
+{
+    for (const auto& c : match_cases) {
+        check(dev::glob_match(c.pattern, c.path) == c.match,
+              std::format("glob_match(\"{}\", \"{}\") == {}", c.pattern, c.path, c.match));
+    }
+
+    Tree tree;
+    auto expect = [&](const Files& patterns, const Files& want,
+                      std::source_location at = std::source_location::current()) {
+        auto got = dev::expand_globs(patterns, tree.root);
+        check(got == want, std::format("expand_globs({}) = {}, want {}", show(patterns),
+                                       show(got), show(want)), at);
+    };
+
+    // Wildcards
+    expect({"*.txt"}, {"a.txt"});
+    expect({"src/*.cpp"}, {"src/main.cpp"});
+    expect({"src/**/*.cpp"}, {"src/main.cpp", "src/util/x.cpp"});
+    expect({"**/*.md"}, {"b.md", "docs/guide/intro.md"});
+    expect({"src/util/?.hpp"}, {"src/util/x.hpp"});
+
+    // Plain names: a file, a whole directory, nothing
+    expect({"a.txt"}, {"a.txt"});
+    expect({"src"}, {"src/main.cpp", "src/util/x.cpp", "src/util/x.hpp"});
+    expect({"docs/guide"}, {"docs/guide/intro.md"});
+    expect({"missing.txt"}, {});
+    expect({"empty"}, {});
+
+    // Dot-directories are skipped on the walk; dot-files are regular files
+    expect({"**"},
+           {".env",
+            "a.txt",
+            "b.md",
+            "docs/guide/intro.md",
+            "src/main.cpp",
+            "src/util/x.cpp",
+            "src/util/x.hpp"});
+
+    // Sorted across patterns, duplicates removed
+    expect({"src/util/x.cpp", "**/*.cpp", "src/*.cpp", "a.txt"},
+           {"a.txt", "src/main.cpp", "src/util/x.cpp"});
+
+    if (g_failures != 0) {
+        std::println(stderr, "{} check(s) failed", g_failures);
+        return 1;
+    }
+    std::println("globs: ok");
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file task_jobserver.cpp
+ * @brief Unit test: `dev task` inside an inherited jobserver (`dev_test_task_jobserver`).
+ *
+ * Sets up a make-style jobserver pipe with one token (two slots: dev's
+ * implicit one plus the token), advertises it through MAKEFLAGS, joins it
+ * with Jobserver::from_env() and runs more independent tasks than slots
+ * on more workers than slots.  Every task logs its start and end; at no
+ * point may more than two run at once, and the token must be back in the
+ * pipe afterwards.
+ *
+ * Exit code: 0 ok, 1 a check failed.
+ */
+
+#include "dev/jobserver.hpp"
+#include "dev/tasks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static int g_failures = 0;
+
+static void
+check(bool ok, std::string_view what, std::source_location at = std::source_location::current())
+{
+    if (!ok) {
+        std::println(stderr, "{}:{}: check failed: {}", at.file_name(), at.line(), what);
+        ++g_failures;
+    }
+}
+
+int main()
+{
+#ifdef _WIN32
+    std::println("task jobserver: skipped (no jobserver on Windows)");
+    return 0;
+#else
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::error_code ec;
+    auto root = fs::temp_directory_path(ec) / ("dev-test-tasks-" + std::to_string(stamp));
+    fs::create_directories(root, ec);
+    fs::current_path(root, ec);
+
+    // What make -j2 hands its children: a pipe with one token.
+    int fds[2];
+    if (::pipe(fds) != 0 || ::write(fds[1], "+", 1) != 1) {
+        std::println(stderr, "cannot create the jobserver pipe");
+        return 1;
+    }
+    auto flags = " -j2 --jobserver-auth=" + std::to_string(fds[0]) + "," + std::to_string(fds[1]);
+    ::setenv("MAKEFLAGS", flags.c_str(), 1);
+
+    auto js = dev::Jobserver::from_env();
+    check(js.has_value(), "joins the inherited jobserver");
+    if (!js) {
+        return 1;
+    }
+    check(js->slots() == 0, "an inherited jobserver reports no slot count");
+
+    std::vector<dev::Task> tasks;
+    std::vector<std::string> targets;
+    for (int i = 0; i < 6; ++i) {
+        dev::Task t;
+        t.name = "t" + std::to_string(i);
+        t.cmd = "echo s >> log; sleep 0.1; echo e >> log";
+        targets.push_back(t.name);
+        tasks.push_back(std::move(t));
+    }
+
+    dev::TaskOptions opts;
+    opts.jobs = 6; // more workers than slots: the tokens must do the limiting
+    opts.quiet = true;
+    opts.jobserver = &*js;
+    check(dev::run_tasks(tasks, targets, opts) == 0, "all tasks succeed");
+
+    std::size_t running = 0;
+    std::size_t peak = 0;
+    std::size_t started = 0;
+    std::ifstream log(root / "log");
+    for (std::string line; std::getline(log, line);) {
+        if (line == "s") {
+            ++started;
+            peak = std::max(peak, ++running);
+        } else if (line == "e" && running > 0) {
+            --running;
+        }
+    }
+    check(started == tasks.size(), "every task ran");
+    check(peak <= 2, "at most two tasks at once (peak " + std::to_string(peak) + ")");
+    check(js->held() == 0, "no token held afterwards");
+
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    char c = 0;
+    check(::read(fds[0], &c, 1) == 1, "the token is back in the pipe");
+
+    fs::current_path(fs::temp_directory_path(ec), ec);
+    fs::remove_all(root, ec);
+
+    if (g_failures != 0) {
+        std::println(stderr, "{} check(s) failed", g_failures);
+        return 1;
+    }
+    std::println("task jobserver: ok");
+    return 0;
+#endif
+}